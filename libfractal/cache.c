@@ -0,0 +1,337 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "store.h"
+
+// Index of neither a tile nor a slot
+#define CACHE_NONE 0xffffffffu
+
+#define CACHE_TILE_BYTES (CACHE_TILE_SIZE * CACHE_TILE_SIZE * sizeof(u32))
+
+static s64 cache_floor_div(s64 value, s64 divisor) {
+    s64 quotient = value / divisor;
+    return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+static void cache_overlap(s64 tile, s64 origin, u32 size, s64 *result_begin, s64 *result_end) {
+    // Overlap of a tile with the view along one axis in pixels of the view
+    s64 begin = tile * CACHE_TILE_SIZE;
+    s64 end = begin + CACHE_TILE_SIZE;
+    *result_begin = (begin > origin ? begin : origin) - origin;
+    *result_end = (end < origin + size ? end : origin + (s64) size) - origin;
+}
+
+static u32 cache_hash(const cache_key_t *key) {
+    // splitmix64 finalizer over the combined coordinates
+    u64 hash = (u64) key->x * 0x9e3779b97f4a7c15ull ^ (u64) key->y * 0xc2b2ae3d27d4eb4full ^ (u64) key->level;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return (u32) (hash ^ (hash >> 31));
+}
+
+static bool cache_key_equal(const cache_key_t *a, const cache_key_t *b) {
+    return a->level == b->level && a->x == b->x && a->y == b->y;
+}
+
+static bool cache_compatible(const cache_tile_t *tile, const fractal_view_t *view) {
+    // The checks may end a few samples along the boundary at a different iteration
+    return tile->precision == fractal_view_precision(view) && tile->periodicity == view->periodicity &&
+           tile->attraction == view->attraction;
+}
+
+static u32 cache_sample(u32 value, u32 tile_limit, u32 view_limit) {
+    // A sample that reached the limit of its tile is only known to escape later than that
+    if (value == CACHE_UNKNOWN) {
+        return value;
+    }
+    if (value < tile_limit) {
+        return value < view_limit ? value : view_limit;
+    }
+    return view_limit <= tile_limit ? view_limit : CACHE_UNKNOWN;
+}
+
+void cache_create(cache_t *self, u64 budget) {
+    u64 capacity = budget / (CACHE_TILE_BYTES + sizeof(cache_tile_t) + 2 * sizeof(u32));
+    self->capacity = (u32) (capacity < 1 ? 1 : capacity > (1u << 30) ? (1u << 30) : capacity);
+
+    // The table is kept at most half full
+    u32 slots = 2;
+    while (slots < 2 * self->capacity) {
+        slots <<= 1;
+    }
+    self->tiles = malloc(self->capacity * sizeof(cache_tile_t));
+    self->slots = malloc(slots * sizeof(u32));
+    ASSERT(self->tiles && self->slots, "[cache] failed to allocate a cache of %u tiles\n", self->capacity);
+    for (u32 i = 0; i < slots; i++) {
+        self->slots[i] = CACHE_NONE;
+    }
+    self->slot_mask = slots - 1;
+    self->count = 0;
+    self->newest = CACHE_NONE;
+    self->oldest = CACHE_NONE;
+    self->hits = 0;
+    self->misses = 0;
+    self->store = NULL;
+}
+
+void cache_destroy(cache_t *self) {
+    cache_flush(self);
+    for (u32 i = 0; i < self->count; i++) {
+        free(self->tiles[i].iterations);
+    }
+    free(self->tiles);
+    free(self->slots);
+    self->tiles = NULL;
+    self->slots = NULL;
+    self->capacity = 0;
+    self->count = 0;
+}
+
+static u32 cache_slot(const cache_t *self, const cache_key_t *key) {
+    // Either the slot of the key or the empty slot where it belongs
+    u32 slot = cache_hash(key) & self->slot_mask;
+    while (self->slots[slot] != CACHE_NONE && !cache_key_equal(&self->tiles[self->slots[slot]].key, key)) {
+        slot = (slot + 1) & self->slot_mask;
+    }
+    return slot;
+}
+
+static void cache_unlink(cache_t *self, u32 index) {
+    cache_tile_t *tile = self->tiles + index;
+    if (tile->newer != CACHE_NONE) {
+        self->tiles[tile->newer].older = tile->older;
+    } else {
+        self->newest = tile->older;
+    }
+    if (tile->older != CACHE_NONE) {
+        self->tiles[tile->older].newer = tile->newer;
+    } else {
+        self->oldest = tile->newer;
+    }
+}
+
+static void cache_link(cache_t *self, u32 index) {
+    cache_tile_t *tile = self->tiles + index;
+    tile->newer = CACHE_NONE;
+    tile->older = self->newest;
+    if (self->newest != CACHE_NONE) {
+        self->tiles[self->newest].newer = index;
+    } else {
+        self->oldest = index;
+    }
+    self->newest = index;
+}
+
+static void cache_remove_slot(cache_t *self, u32 slot) {
+    // Backward shift deletion, following entries of the probe sequence move into the gap
+    u32 gap = slot;
+    u32 next = (slot + 1) & self->slot_mask;
+    while (self->slots[next] != CACHE_NONE) {
+        u32 home = cache_hash(&self->tiles[self->slots[next]].key) & self->slot_mask;
+        if (((next - home) & self->slot_mask) >= ((next - gap) & self->slot_mask)) {
+            self->slots[gap] = self->slots[next];
+            gap = next;
+        }
+        next = (next + 1) & self->slot_mask;
+    }
+    self->slots[gap] = CACHE_NONE;
+}
+
+static cache_tile_t *cache_find(cache_t *self, const cache_key_t *key) {
+    u32 index = self->slots[cache_slot(self, key)];
+    if (index == CACHE_NONE) {
+        return NULL;
+    }
+    cache_unlink(self, index);
+    cache_link(self, index);
+    return self->tiles + index;
+}
+
+static cache_tile_t *cache_insert(cache_t *self, const cache_key_t *key) {
+    // New tiles take a fresh entry until the budget is exhausted, then the oldest one which is
+    // persisted first if it changed
+    u32 index;
+    if (self->count < self->capacity) {
+        index = self->count++;
+        self->tiles[index].iterations = malloc(CACHE_TILE_BYTES);
+        ASSERT(self->tiles[index].iterations, "[cache] failed to allocate a tile\n");
+    } else {
+        index = self->oldest;
+        if (self->store && self->tiles[index].dirty) {
+            store_write(self->store, self->tiles + index);
+        }
+        cache_remove_slot(self, cache_slot(self, &self->tiles[index].key));
+        cache_unlink(self, index);
+    }
+    cache_tile_t *tile = self->tiles + index;
+    tile->key = *key;
+    tile->dirty = false;
+    self->slots[cache_slot(self, key)] = index;
+    cache_link(self, index);
+    for (u32 i = 0; i < CACHE_TILE_SIZE * CACHE_TILE_SIZE; i++) {
+        tile->iterations[i] = CACHE_UNKNOWN;
+    }
+    return tile;
+}
+
+static void cache_describe(cache_tile_t *tile, const cache_key_t *key, const fractal_view_t *view) {
+    tile->key = *key;
+    tile->precision = fractal_view_precision(view);
+    tile->periodicity = view->periodicity;
+    tile->attraction = view->attraction;
+}
+
+static void cache_restore(cache_t *self, cache_tile_t *tile, const fractal_view_t *view) {
+    // A tile that is new to the cache may have been persisted, its samples outside of the view
+    // are kept then
+    cache_describe(tile, &tile->key, view);
+    tile->max_iterations = view->max_iterations;
+    u32 max_iterations;
+    const u32 *samples = self->store ? store_find(self->store, tile, &max_iterations) : NULL;
+    if (samples) {
+        memcpy(tile->iterations, samples, CACHE_TILE_BYTES);
+        tile->max_iterations = max_iterations;
+    }
+}
+
+void cache_attach(cache_t *self, struct store *store) {
+    self->store = store;
+}
+
+void cache_flush(cache_t *self) {
+    if (self->store == NULL) {
+        return;
+    }
+    for (u32 i = 0; i < self->count; i++) {
+        if (self->tiles[i].dirty) {
+            store_write(self->store, self->tiles + i);
+            self->tiles[i].dirty = false;
+        }
+    }
+}
+
+u32 cache_load(cache_t *self, const fractal_view_t *view, u32 *iterations) {
+    for (u32 i = 0; i < view->width * view->height; i++) {
+        iterations[i] = CACHE_UNKNOWN;
+    }
+    s32 level;
+    s64 origin_x, origin_y;
+    if (!fractal_view_lattice(view, &level, &origin_x, &origin_y)) {
+        return 0;
+    }
+
+    s64 tile_x0 = cache_floor_div(origin_x, CACHE_TILE_SIZE);
+    s64 tile_y0 = cache_floor_div(origin_y, CACHE_TILE_SIZE);
+    s64 tile_x1 = cache_floor_div(origin_x + view->width - 1, CACHE_TILE_SIZE);
+    s64 tile_y1 = cache_floor_div(origin_y + view->height - 1, CACHE_TILE_SIZE);
+    u32 known = 0;
+    for (s64 tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+        for (s64 tile_x = tile_x0; tile_x <= tile_x1; tile_x++) {
+            // Tiles that are not in memory are read from the store in place
+            cache_key_t key = {level, tile_x, tile_y};
+            cache_tile_t *tile = cache_find(self, &key);
+            const u32 *samples = NULL;
+            u32 max_iterations = 0;
+            if (tile && cache_compatible(tile, view)) {
+                samples = tile->iterations;
+                max_iterations = tile->max_iterations;
+            } else if (self->store) {
+                cache_tile_t probe;
+                cache_describe(&probe, &key, view);
+                samples = store_find(self->store, &probe, &max_iterations);
+            }
+            if (samples == NULL) {
+                self->misses++;
+                continue;
+            }
+            self->hits++;
+
+            s64 x0, y0, x1, y1;
+            cache_overlap(tile_x, origin_x, view->width, &x0, &x1);
+            cache_overlap(tile_y, origin_y, view->height, &y0, &y1);
+            for (s64 y = y0; y < y1; y++) {
+                const u32 *source = samples + (origin_y + y - tile_y * CACHE_TILE_SIZE) * CACHE_TILE_SIZE +
+                                    (origin_x - tile_x * CACHE_TILE_SIZE);
+                u32 *target = iterations + y * view->width;
+                for (s64 x = x0; x < x1; x++) {
+                    target[x] = cache_sample(source[x], max_iterations, view->max_iterations);
+                    known += target[x] != CACHE_UNKNOWN;
+                }
+            }
+        }
+    }
+    return known;
+}
+
+void cache_store(cache_t *self, const fractal_view_t *view, const u32 *iterations) {
+    s32 level;
+    s64 origin_x, origin_y;
+    if (!fractal_view_lattice(view, &level, &origin_x, &origin_y)) {
+        return;
+    }
+
+    s64 tile_x0 = cache_floor_div(origin_x, CACHE_TILE_SIZE);
+    s64 tile_y0 = cache_floor_div(origin_y, CACHE_TILE_SIZE);
+    s64 tile_x1 = cache_floor_div(origin_x + view->width - 1, CACHE_TILE_SIZE);
+    s64 tile_y1 = cache_floor_div(origin_y + view->height - 1, CACHE_TILE_SIZE);
+    for (s64 tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+        for (s64 tile_x = tile_x0; tile_x <= tile_x1; tile_x++) {
+            cache_key_t key = {level, tile_x, tile_y};
+            cache_tile_t *tile = cache_find(self, &key);
+            if (tile == NULL) {
+                tile = cache_insert(self, &key);
+                cache_restore(self, tile, view);
+            }
+            if (!cache_compatible(tile, view)) {
+                for (u32 i = 0; i < CACHE_TILE_SIZE * CACHE_TILE_SIZE; i++) {
+                    tile->iterations[i] = CACHE_UNKNOWN;
+                }
+            } else if (tile->max_iterations != view->max_iterations) {
+                for (u32 i = 0; i < CACHE_TILE_SIZE * CACHE_TILE_SIZE; i++) {
+                    tile->iterations[i] = cache_sample(tile->iterations[i], tile->max_iterations, view->max_iterations);
+                }
+            }
+            cache_describe(tile, &key, view);
+            tile->max_iterations = view->max_iterations;
+            tile->dirty = true;
+
+            s64 x0, y0, x1, y1;
+            cache_overlap(tile_x, origin_x, view->width, &x0, &x1);
+            cache_overlap(tile_y, origin_y, view->height, &y0, &y1);
+            for (s64 y = y0; y < y1; y++) {
+                u32 *target = tile->iterations + (origin_y + y - tile_y * CACHE_TILE_SIZE) * CACHE_TILE_SIZE +
+                              (origin_x - tile_x * CACHE_TILE_SIZE);
+                const u32 *source = iterations + y * view->width;
+                for (s64 x = x0; x < x1; x++) {
+                    target[x] = source[x];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_CACHE_H
+#define LIBFRACTAL_CACHE_H
+
+#include "types.h"
+#include "view.h"
+
+/**
+ * Width and height of a tile in lattice points
+ */
+#define CACHE_TILE_SIZE 64
+
+/**
+ * Samples of a tile that were never evaluated
+ */
+#define CACHE_UNKNOWN 0xffffffffu
+
+/**
+ * Memory budget of the pipeline's cache in bytes
+ */
+#define CACHE_BUDGET_DEFAULT (256ull << 20)
+
+/**
+ * Address of a tile in the global quadtree. Tile (x, y) of level l holds the lattice points
+ * [x T, x T + T) x [y T, y T + T) of that level, see fractal_view_lattice, and its four
+ * children are the tiles (2 x + i, 2 y + j) of level l + 1.
+ */
+typedef struct cache_key {
+    s32 level;
+    s64 x;
+    s64 y;
+} cache_key_t;
+
+/**
+ * A tile keeps the iteration limit, precision and interior checks of the views it was stored
+ * from, samples outside of those views are CACHE_UNKNOWN. Dirty tiles changed since they
+ * were last persisted.
+ */
+typedef struct cache_tile {
+    cache_key_t key;
+    u32 max_iterations;
+    fractal_precision_t precision;
+    bool periodicity;
+    bool attraction;
+    bool dirty;
+    u32 *iterations;
+    u32 newer;
+    u32 older;
+} cache_tile_t;
+
+/**
+ * Cache of iteration tiles with a fixed memory budget, the least recently used tile is evicted
+ * once the budget is exhausted. Tiles are found through an open addressing table of indices
+ * into tiles. An attached store persists evicted tiles and serves those that are not in memory.
+ * The cache is not thread safe.
+ */
+typedef struct cache {
+    cache_tile_t *tiles;
+    u32 *slots;
+    u32 slot_mask;
+    u32 capacity;
+    u32 count;
+    u32 newest;
+    u32 oldest;
+    u64 hits;
+    u64 misses;
+    struct store *store;
+} cache_t;
+
+/**
+ * Creates an empty cache, the tiles are allocated as they are stored
+ *
+ * @param self cache handle
+ * @param budget memory budget in bytes, at least one tile is kept
+ */
+void cache_create(cache_t *self, u64 budget);
+
+/**
+ * Persists the dirty tiles and releases all tiles of the cache
+ *
+ * @param self cache handle
+ */
+void cache_destroy(cache_t *self);
+
+/**
+ * Attaches a store as the persistent tier of the cache, the store has to stay open until the
+ * cache is destroyed
+ *
+ * @param self cache handle
+ * @param store store handle, NULL detaches the store
+ */
+void cache_attach(cache_t *self, struct store *store);
+
+/**
+ * Writes every dirty tile to the attached store
+ *
+ * @param self cache handle
+ */
+void cache_flush(cache_t *self);
+
+/**
+ * Fills the pixels of a view from the cached tiles or the attached store, pixels neither knows
+ * are set to CACHE_UNKNOWN. Samples of tiles with a lower iteration limit that reached it are
+ * unknown as well, a higher limit is clamped. Views off the lattice (see fractal_view_lattice)
+ * find nothing.
+ *
+ * @param self cache handle
+ * @param view view handle
+ * @param iterations pointer to the resulting iterations of every pixel
+ * @return number of known pixels
+ */
+u32 cache_load(cache_t *self, const fractal_view_t *view, u32 *iterations);
+
+/**
+ * Stores the pixels of a view in the tiles it overlaps, samples the tiles already hold outside
+ * of the view are kept if they are valid at the iteration limit, precision and checks of the view.
+ * Views off the lattice are not stored.
+ *
+ * @param self cache handle
+ * @param view view handle
+ * @param iterations iterations of every pixel
+ */
+void cache_store(cache_t *self, const fractal_view_t *view, const u32 *iterations);
+
+#endif// LIBFRACTAL_CACHE_H
@@ -0,0 +1,343 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+
+#include "cpu.h"
+#include "math.h"
+#include "perturb.h"
+
+#define FRACTAL_CPU_CHUNK 64
+#define FRACTAL_CPU_TILE 32
+
+// ===================================================================================
+// REFERENCE RENDERER
+// ===================================================================================
+
+bool fractal_cpu_interior(f32 cx, f32 cy) {
+    f32 xq = cx - 0.25f;
+    f32 yy = cy * cy;
+    f32 q = xq * xq + yy;
+    f32 bulb = (cx + 1.0f) * (cx + 1.0f) + yy;
+    return q * (q + xq) < 0.25f * yy || bulb < 0.0625f;
+}
+
+u32 fractal_cpu_iterate(f32 cx, f32 cy, u32 max_iterations) {
+    // Same operations in the same order as the shader, note that the bailout
+    // is tested on z^2 before c is added
+    if (fractal_cpu_interior(cx, cy)) {
+        return max_iterations;
+    }
+    u32 iteration = 0;
+    f32 zx = 0.0f;
+    f32 zy = 0.0f;
+    for (; iteration < max_iterations; ++iteration) {
+        f32 x = zx * zx - zy * zy;
+        f32 y = 2.0f * zx * zy;
+        if (x * x + y * y > 4.0f) {
+            break;
+        }
+        zx = x + cx;
+        zy = y + cy;
+    }
+    return iteration;
+}
+
+void fractal_cpu_color(u32 iteration, u32 max_iterations, f32vec4_t *result) {
+    if (iteration < max_iterations) {
+        f32 t = (f32) iteration / (f32) max_iterations;
+        result->x = 9.0f * (1.0f - t) * t * t * t;
+        result->y = 15.0f * (1.0f - t) * (1.0f - t) * t * t;
+        result->z = 8.5f * (1.0f - t) * (1.0f - t) * (1.0f - t) * t;
+        result->w = 1.0f;
+    } else {
+        result->x = 0.0f;
+        result->y = 0.0f;
+        result->z = 0.0f;
+        result->w = 0.0f;
+    }
+}
+
+f32 fractal_cpu_value(u32 iteration, u32 max_iterations) {
+    return iteration < max_iterations ? (f32) iteration : -1.0f;
+}
+
+void fractal_cpu_color_distance(f64 distance, f32vec4_t *result) {
+    if (distance > 0.0) {
+        f32 t = (f32) fmin(1.0, sqrt(distance / FRACTAL_CPU_DISTANCE_RANGE));
+        result->x = t;
+        result->y = t;
+        result->z = t;
+        result->w = 1.0f;
+    } else {
+        result->x = 0.0f;
+        result->y = 0.0f;
+        result->z = 0.0f;
+        result->w = 0.0f;
+    }
+}
+
+void fractal_cpu_render(const fractal_view_t *view, u32 *iterations, f32vec4_t *colors, kernel_stats_t *stats) {
+    fractal_cpu_render_kernel(view, kernel_select(), iterations, colors, stats);
+}
+
+static u32 fractal_cpu_checks(const fractal_view_t *view) {
+    return (view->periodicity ? KERNEL_CHECK_PERIODICITY : 0) | (view->attraction ? KERNEL_CHECK_ATTRACTION : 0);
+}
+
+static void fractal_cpu_render_region(const fractal_view_t *view, const kernel_t *kernel,
+                                      fractal_precision_t precision, u32 x0, u32 y0, u32 x1, u32 y1,
+                                      u32 *iterations, kernel_stats_t *stats) {
+    // Points are handed to the kernel in chunks that live on the stack
+    for (u32 y = y0; y < y1; y++) {
+        for (u32 x = x0; x < x1; x += FRACTAL_CPU_CHUNK) {
+            u32 count = (u32) s32_min(FRACTAL_CPU_CHUNK, (s32) (x1 - x));
+            u32 *result = iterations + y * view->width + x;
+            if (precision == FRACTAL_PRECISION_F32) {
+                f32 cx[FRACTAL_CPU_CHUNK];
+                f32 cy[FRACTAL_CPU_CHUNK];
+                for (u32 i = 0; i < count; i++) {
+                    f64 point_x, point_y;
+                    fractal_view_pixel(view, x + i, y, &point_x, &point_y);
+                    cx[i] = (f32) point_x;
+                    cy[i] = (f32) point_y;
+                }
+                kernel->f32(cx, cy, count, view->max_iterations, fractal_cpu_checks(view), result, stats);
+            } else if (precision == FRACTAL_PRECISION_F64) {
+                f64 cx[FRACTAL_CPU_CHUNK];
+                f64 cy[FRACTAL_CPU_CHUNK];
+                for (u32 i = 0; i < count; i++) {
+                    fractal_view_pixel(view, x + i, y, cx + i, cy + i);
+                }
+                kernel->f64(cx, cy, count, view->max_iterations, fractal_cpu_checks(view), result, stats);
+            } else {
+                // Perturbation views are rendered with perturb_render, which needs a reference
+                // orbit, double-double is the best a single region can do without one
+                ddouble_t cx[FRACTAL_CPU_CHUNK];
+                ddouble_t cy[FRACTAL_CPU_CHUNK];
+                for (u32 i = 0; i < count; i++) {
+                    fractal_view_pixel_ddouble(view, x + i, y, cx + i, cy + i);
+                }
+                kernel_ddouble_t ddouble = kernel->ddouble ? kernel->ddouble : kernel_scalar.ddouble;
+                ddouble(cx, cy, count, view->max_iterations, fractal_cpu_checks(view), result, stats);
+            }
+        }
+    }
+}
+
+void fractal_cpu_render_pixels(const fractal_view_t *view, const kernel_t *kernel, fractal_precision_t precision,
+                               const u32 *pixels, u32 count, u32 *iterations, kernel_stats_t *stats) {
+    // Same as fractal_cpu_render_region, but the chunks are gathered from arbitrary pixels
+    // and the results are scattered back afterwards
+    for (u32 begin = 0; begin < count; begin += FRACTAL_CPU_CHUNK) {
+        u32 chunk = (u32) s32_min(FRACTAL_CPU_CHUNK, (s32) (count - begin));
+        const u32 *indices = pixels + begin;
+        u32 result[FRACTAL_CPU_CHUNK];
+        if (precision == FRACTAL_PRECISION_F32) {
+            f32 cx[FRACTAL_CPU_CHUNK];
+            f32 cy[FRACTAL_CPU_CHUNK];
+            for (u32 i = 0; i < chunk; i++) {
+                f64 point_x, point_y;
+                fractal_view_pixel(view, indices[i] % view->width, indices[i] / view->width, &point_x, &point_y);
+                cx[i] = (f32) point_x;
+                cy[i] = (f32) point_y;
+            }
+            kernel->f32(cx, cy, chunk, view->max_iterations, fractal_cpu_checks(view), result, stats);
+        } else if (precision == FRACTAL_PRECISION_F64) {
+            f64 cx[FRACTAL_CPU_CHUNK];
+            f64 cy[FRACTAL_CPU_CHUNK];
+            for (u32 i = 0; i < chunk; i++) {
+                fractal_view_pixel(view, indices[i] % view->width, indices[i] / view->width, cx + i, cy + i);
+            }
+            kernel->f64(cx, cy, chunk, view->max_iterations, fractal_cpu_checks(view), result, stats);
+        } else {
+            ddouble_t cx[FRACTAL_CPU_CHUNK];
+            ddouble_t cy[FRACTAL_CPU_CHUNK];
+            for (u32 i = 0; i < chunk; i++) {
+                fractal_view_pixel_ddouble(view, indices[i] % view->width, indices[i] / view->width, cx + i, cy + i);
+            }
+            kernel_ddouble_t ddouble = kernel->ddouble ? kernel->ddouble : kernel_scalar.ddouble;
+            ddouble(cx, cy, chunk, view->max_iterations, fractal_cpu_checks(view), result, stats);
+        }
+        for (u32 i = 0; i < chunk; i++) {
+            iterations[indices[i]] = result[i];
+        }
+    }
+}
+
+static void fractal_cpu_render_distance_region(const fractal_view_t *view, const kernel_t *kernel, u32 x0, u32 y0,
+                                               u32 x1, u32 y1, u32 *iterations, f64 *distances,
+                                               kernel_stats_t *stats) {
+    // There are only double precision distance kernels, the estimate is converted to pixels
+    kernel_distance_t distance = kernel->distance ? kernel->distance : kernel_scalar.distance;
+    for (u32 y = y0; y < y1; y++) {
+        for (u32 x = x0; x < x1; x += FRACTAL_CPU_CHUNK) {
+            u32 count = (u32) s32_min(FRACTAL_CPU_CHUNK, (s32) (x1 - x));
+            u32 index = y * view->width + x;
+            f64 cx[FRACTAL_CPU_CHUNK];
+            f64 cy[FRACTAL_CPU_CHUNK];
+            for (u32 i = 0; i < count; i++) {
+                fractal_view_pixel(view, x + i, y, cx + i, cy + i);
+            }
+            distance(cx, cy, count, view->max_iterations, iterations + index, distances + index, stats);
+            for (u32 i = 0; i < count; i++) {
+                distances[index + i] /= view->scale;
+            }
+        }
+    }
+}
+
+static void fractal_cpu_color_region(const fractal_view_t *view, u32 x0, u32 y0, u32 x1, u32 y1,
+                                     const u32 *iterations, f32vec4_t *colors) {
+    for (u32 y = y0; y < y1; y++) {
+        for (u32 x = x0; x < x1; x++) {
+            u32 index = y * view->width + x;
+            fractal_cpu_color(iterations[index], view->max_iterations, colors + index);
+        }
+    }
+}
+
+static void fractal_cpu_render_perturbation(thread_pool_t *pool, const fractal_view_t *view, u32 *iterations,
+                                            kernel_stats_t *stats) {
+    // The reference orbit only lives for this frame, the refinement keeps its own across frames
+    perturb_t perturb;
+    perturb_create(&perturb);
+    perturb_center_view(&perturb, view);
+    perturb_render(&perturb, pool, view, iterations);
+    stats->rejected += perturb.stats.rejected;
+    perturb_destroy(&perturb);
+}
+
+void fractal_cpu_render_kernel(const fractal_view_t *view, const kernel_t *kernel, u32 *iterations, f32vec4_t *colors,
+                               kernel_stats_t *stats) {
+    fractal_precision_t precision = fractal_view_precision(view);
+    kernel_stats_t frame = {0};
+    if (precision == FRACTAL_PRECISION_PERTURBATION) {
+        fractal_cpu_render_perturbation(NULL, view, iterations, &frame);
+    } else {
+        fractal_cpu_render_region(view, kernel, precision, 0, 0, view->width, view->height, iterations, &frame);
+    }
+    if (colors) {
+        fractal_cpu_color_region(view, 0, 0, view->width, view->height, iterations, colors);
+    }
+    if (stats) {
+        *stats = frame;
+    }
+}
+
+// ===================================================================================
+// PARALLEL RENDERER
+// ===================================================================================
+
+typedef struct fractal_cpu_job {
+    const fractal_view_t *view;
+    const kernel_t *kernel;
+    fractal_precision_t precision;
+    u32 *iterations;
+    f64 *distances;
+    f32vec4_t *colors;
+    u32 tiles_x;
+    atomic_uint rejected;
+    atomic_uint periodic;
+    atomic_uint attracted;
+} fractal_cpu_job_t;
+
+static void fractal_cpu_render_tile(void *user, u32 tile, u32 worker) {
+    fractal_cpu_job_t *job = user;
+    u32 x0 = (tile % job->tiles_x) * FRACTAL_CPU_TILE;
+    u32 y0 = (tile / job->tiles_x) * FRACTAL_CPU_TILE;
+    u32 x1 = (u32) s32_min((s32) (x0 + FRACTAL_CPU_TILE), (s32) job->view->width);
+    u32 y1 = (u32) s32_min((s32) (y0 + FRACTAL_CPU_TILE), (s32) job->view->height);
+    kernel_stats_t stats = {0};
+    if (job->distances) {
+        fractal_cpu_render_distance_region(job->view, job->kernel, x0, y0, x1, y1, job->iterations, job->distances,
+                                           &stats);
+        for (u32 y = y0; y < y1 && job->colors; y++) {
+            for (u32 x = x0; x < x1; x++) {
+                u32 index = y * job->view->width + x;
+                fractal_cpu_color_distance(job->distances[index], job->colors + index);
+            }
+        }
+    } else {
+        fractal_cpu_render_region(job->view, job->kernel, job->precision, x0, y0, x1, y1, job->iterations, &stats);
+        if (job->colors) {
+            fractal_cpu_color_region(job->view, x0, y0, x1, y1, job->iterations, job->colors);
+        }
+    }
+    atomic_fetch_add(&job->rejected, stats.rejected);
+    atomic_fetch_add(&job->periodic, stats.periodic);
+    atomic_fetch_add(&job->attracted, stats.attracted);
+}
+
+static void fractal_cpu_run(thread_pool_t *pool, fractal_cpu_job_t *job, kernel_stats_t *stats) {
+    const fractal_view_t *view = job->view;
+    job->kernel = kernel_select();
+    job->precision = fractal_view_precision(view);
+    job->tiles_x = (view->width + FRACTAL_CPU_TILE - 1) / FRACTAL_CPU_TILE;
+    u32 tiles = job->tiles_x * ((view->height + FRACTAL_CPU_TILE - 1) / FRACTAL_CPU_TILE);
+    atomic_init(&job->rejected, 0);
+    atomic_init(&job->periodic, 0);
+    atomic_init(&job->attracted, 0);
+    if (!job->distances && job->precision == FRACTAL_PRECISION_PERTURBATION) {
+        // The tiles share a single reference orbit, perturb_render distributes them itself
+        kernel_stats_t frame = {0};
+        fractal_cpu_render_perturbation(pool, view, job->iterations, &frame);
+        atomic_store(&job->rejected, frame.rejected);
+        if (job->colors) {
+            fractal_cpu_color_region(view, 0, 0, view->width, view->height, job->iterations, job->colors);
+        }
+    } else if (pool) {
+        thread_pool_run(pool, tiles, fractal_cpu_render_tile, job);
+    } else {
+        for (u32 tile = 0; tile < tiles; tile++) {
+            fractal_cpu_render_tile(job, tile, 0);
+        }
+    }
+    if (stats) {
+        stats->rejected = atomic_load(&job->rejected);
+        stats->periodic = atomic_load(&job->periodic);
+        stats->attracted = atomic_load(&job->attracted);
+        stats->filled = 0;
+    }
+}
+
+void fractal_cpu_render_parallel(thread_pool_t *pool, const fractal_view_t *view, u32 *iterations,
+                                 f32vec4_t *colors, kernel_stats_t *stats) {
+    fractal_cpu_job_t job;
+    job.view = view;
+    job.iterations = iterations;
+    job.distances = NULL;
+    job.colors = colors;
+    fractal_cpu_run(pool, &job, stats);
+}
+
+void fractal_cpu_render_distance(thread_pool_t *pool, const fractal_view_t *view, u32 *iterations, f64 *distances,
+                                 f32vec4_t *colors, kernel_stats_t *stats) {
+    fractal_cpu_job_t job;
+    job.view = view;
+    job.iterations = iterations;
+    job.distances = distances;
+    job.colors = colors;
+    fractal_cpu_run(pool, &job, stats);
+}
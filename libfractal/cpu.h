@@ -0,0 +1,159 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_CPU_H
+#define LIBFRACTAL_CPU_H
+
+#include "kernel.h"
+#include "thread.h"
+#include "types.h"
+#include "view.h"
+
+/**
+ * Tests whether the point lies inside the main cardioid or the period-2 bulb in
+ * single precision, the same test the fragment shader runs before iterating
+ *
+ * @param cx real part of the point
+ * @param cy imaginary part of the point
+ * @return bool
+ */
+bool fractal_cpu_interior(f32 cx, f32 cy);
+
+/**
+ * Iterates a single point exactly the way the mandelbrot() function of the
+ * fragment shader does, this is the reference every other kernel is validated against
+ *
+ * @param cx real part of the point
+ * @param cy imaginary part of the point
+ * @param max_iterations iteration limit
+ * @return number of iterations until escape, max_iterations for interior points
+ */
+u32 fractal_cpu_iterate(f32 cx, f32 cy, u32 max_iterations);
+
+/**
+ * Converts an iteration count into the color the color pass outputs for it with the
+ * default palette, see fractal_palette_t
+ *
+ * @param iteration iteration count
+ * @param max_iterations iteration limit
+ * @param result pointer to the resulting color
+ */
+void fractal_cpu_color(u32 iteration, u32 max_iterations, f32vec4_t *result);
+
+/**
+ * Converts an iteration count into the value the iteration pass of the fragment shaders
+ * outputs for it, the color pass turns values into colors
+ *
+ * @param iteration iteration count
+ * @param max_iterations iteration limit
+ * @return iteration count, -1 for points that did not escape
+ */
+f32 fractal_cpu_value(u32 iteration, u32 max_iterations);
+
+/**
+ * Distance in pixels at which fractal_cpu_color_distance reaches full brightness,
+ * the distance shader uses the same value
+ */
+#define FRACTAL_CPU_DISTANCE_RANGE 16.0
+
+/**
+ * Converts a distance estimate into the color the distance shader outputs for it,
+ * the brightness grows with the square root of the distance to the set
+ *
+ * @param distance distance estimate in pixels, 0 for interior points
+ * @param result pointer to the resulting color
+ */
+void fractal_cpu_color_distance(f64 distance, f32vec4_t *result);
+
+/**
+ * Renders the view on the cpu with the kernel picked by kernel_select, both buffers are provided
+ * by the caller and hold width * height elements in row-major order starting at the bottom row.
+ * Views that are zoomed in too far for single precision are rendered in double precision,
+ * views too deep for that in double-double precision and views beyond that with perturb_render.
+ *
+ * @param view view handle
+ * @param iterations iteration count per pixel
+ * @param colors color per pixel, may be NULL if only iterations are needed
+ * @param stats counters of the frame, may be NULL
+ */
+void fractal_cpu_render(const fractal_view_t *view, u32 *iterations, f32vec4_t *colors, kernel_stats_t *stats);
+
+/**
+ * Renders the view on the cpu with the specified kernel, see fractal_cpu_render
+ *
+ * @param view view handle
+ * @param kernel kernel handle
+ * @param iterations iteration count per pixel
+ * @param colors color per pixel, may be NULL if only iterations are needed
+ * @param stats counters of the frame, may be NULL
+ */
+void fractal_cpu_render_kernel(const fractal_view_t *view, const kernel_t *kernel, u32 *iterations, f32vec4_t *colors,
+                               kernel_stats_t *stats);
+
+/**
+ * Evaluates only the specified pixels of the view, the renderers that skip pixels
+ * collect what they need and hand it over in one batch so the kernels stay busy. There is no
+ * reference orbit at hand here, perturbation views are evaluated in double-double precision,
+ * see perturb_render_pixels.
+ *
+ * @param view view handle
+ * @param kernel kernel handle
+ * @param precision precision of the view, see fractal_view_precision
+ * @param pixels pixel indices (y * width + x)
+ * @param count number of pixels
+ * @param iterations iteration count per pixel of the whole view, only the specified pixels are written
+ * @param stats counters that are incremented
+ */
+void fractal_cpu_render_pixels(const fractal_view_t *view, const kernel_t *kernel, fractal_precision_t precision,
+                               const u32 *pixels, u32 count, u32 *iterations, kernel_stats_t *stats);
+
+/**
+ * Renders the view on the cpu like fractal_cpu_render, but splits the frame into
+ * tiles which are distributed over the workers of the pool
+ *
+ * @param pool pool handle
+ * @param view view handle
+ * @param iterations iteration count per pixel
+ * @param colors color per pixel, may be NULL if only iterations are needed
+ * @param stats counters of the frame, may be NULL
+ */
+void fractal_cpu_render_parallel(thread_pool_t *pool, const fractal_view_t *view, u32 *iterations,
+                                 f32vec4_t *colors, kernel_stats_t *stats);
+
+/**
+ * Renders the exterior distance estimate of every pixel with the distance kernel of the kernel
+ * picked by kernel_select. Points are evaluated in double precision regardless of the zoom depth,
+ * the iteration counts follow the larger bailout radius of the distance kernels.
+ *
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @param view view handle
+ * @param iterations iteration count per pixel
+ * @param distances distance to the set per pixel in pixels, 0 for interior points
+ * @param colors color per pixel, may be NULL if only distances are needed
+ * @param stats counters of the frame, may be NULL
+ */
+void fractal_cpu_render_distance(thread_pool_t *pool, const fractal_view_t *view, u32 *iterations, f64 *distances,
+                                 f32vec4_t *colors, kernel_stats_t *stats);
+
+#endif// LIBFRACTAL_CPU_H
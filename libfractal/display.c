@@ -37,6 +37,42 @@ static void display_framebuffer_callback(GLFWwindow *handle, s32 width, s32 heig
     glViewport(0, 0, width, height);
 }
 
+static void display_cursor_callback(GLFWwindow *handle, f64 x, f64 y) {
+    display_t *self = glfwGetWindowUserPointer(handle);
+    if (!self) {
+        return;
+    }
+
+    // Window coordinates start at the top left and may differ from framebuffer pixels
+    s32 window_width, window_height;
+    glfwGetWindowSize(handle, &window_width, &window_height);
+    if (window_width <= 0 || window_height <= 0) {
+        return;
+    }
+    f64 cursor_x = x * (f64) self->width / (f64) window_width;
+    f64 cursor_y = (f64) self->height - y * (f64) self->height / (f64) window_height;
+    if (self->input.dragging) {
+        self->input.drag_x += cursor_x - self->input.cursor_x;
+        self->input.drag_y += cursor_y - self->input.cursor_y;
+    }
+    self->input.cursor_x = cursor_x;
+    self->input.cursor_y = cursor_y;
+}
+
+static void display_mouse_button_callback(GLFWwindow *handle, s32 button, s32 action, s32 mods) {
+    display_t *self = glfwGetWindowUserPointer(handle);
+    if (self && button == GLFW_MOUSE_BUTTON_LEFT) {
+        self->input.dragging = action == GLFW_PRESS;
+    }
+}
+
+static void display_scroll_callback(GLFWwindow *handle, f64 x, f64 y) {
+    display_t *self = glfwGetWindowUserPointer(handle);
+    if (self) {
+        self->input.scroll += y;
+    }
+}
+
 static const char *severity_string(u32 severity) {
     switch (severity) {
         case GL_DEBUG_SEVERITY_HIGH: {
@@ -82,6 +118,12 @@ bool display_create(display_t *self, const char *title, u32 width, u32 height) {
     self->width = width;
     self->height = height;
     self->time = glfwGetTime();
+    self->input.cursor_x = 0.0;
+    self->input.cursor_y = 0.0;
+    self->input.drag_x = 0.0;
+    self->input.drag_y = 0.0;
+    self->input.scroll = 0.0;
+    self->input.dragging = false;
 
     if (!self->handle) {
         glfwTerminate();
@@ -97,6 +139,9 @@ bool display_create(display_t *self, const char *title, u32 width, u32 height) {
     glfwSetInputMode(self->handle, GLFW_STICKY_KEYS, GLFW_TRUE);
     glfwSetWindowUserPointer(self->handle, self);
     glfwSetFramebufferSizeCallback(self->handle, display_framebuffer_callback);
+    glfwSetCursorPosCallback(self->handle, display_cursor_callback);
+    glfwSetMouseButtonCallback(self->handle, display_mouse_button_callback);
+    glfwSetScrollCallback(self->handle, display_scroll_callback);
     glEnable(GL_DEBUG_OUTPUT);
     glDebugMessageCallback(display_error_callback, NULL);
     return true;
@@ -108,6 +153,9 @@ void display_destroy(display_t *self) {
 }
 
 f64 display_update_frame(display_t *self) {
+    self->input.drag_x = 0.0;
+    self->input.drag_y = 0.0;
+    self->input.scroll = 0.0;
     glfwPollEvents();
     glfwSwapBuffers(self->handle);
     f64 time = glfwGetTime();
@@ -29,12 +29,22 @@
 
 #include <GLFW/glfw3.h>
 
+typedef struct display_input {
+    f64 cursor_x;
+    f64 cursor_y;
+    f64 drag_x;
+    f64 drag_y;
+    f64 scroll;
+    bool dragging;
+} display_input_t;
+
 typedef struct display {
     GLFWwindow* handle;
     u32 width;
     u32 height;
     f64 time;
     bool running;
+    display_input_t input;
 } display_t;
 
 /**
@@ -56,7 +66,8 @@ bool display_create(display_t* self, const char* title, u32 width, u32 height);
 void display_destroy(display_t* self);
 
 /**
- * Swaps front and back buffer
+ * Swaps front and back buffer and polls the input. Cursor positions are in framebuffer pixels
+ * with the origin at the bottom left, drag and scroll are accumulated over the last frame.
  *
  * @param self display handle
  * @return frame time
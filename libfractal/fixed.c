@@ -0,0 +1,428 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "fixed.h"
+
+// Below this many limbs the Karatsuba recursion falls back to schoolbook
+#define FIXED_KARATSUBA_BASE 32
+
+// Scratch space for the Karatsuba recursion, which needs about 4 n limbs in total
+#define FIXED_SCRATCH_LIMBS (8 * FIXED_MAX_LIMBS)
+
+// ===================================================================================
+// LIMB ARRAYS
+// ===================================================================================
+
+// Full products work on little-endian limb arrays, limb 0 being the least significant
+
+static void fixed_limbs_schoolbook(const u32 *a, const u32 *b, u32 n, u32 *result) {
+    // Column by column, so the carries only ripple once per column
+    u64 carry = 0;
+    for (u32 k = 0; k + 1 < 2 * n; k++) {
+        u64 low = carry;
+        u64 high = 0;
+        for (u32 i = k < n ? 0 : k - n + 1; i <= k && i < n; i++) {
+            u64 product = (u64) a[i] * b[k - i];
+            low += (u32) product;
+            high += product >> 32;
+        }
+        result[k] = (u32) low;
+        carry = (low >> 32) + high;
+    }
+    result[2 * n - 1] = (u32) carry;
+}
+
+static void fixed_limbs_schoolbook_square(const u32 *a, u32 n, u32 *result) {
+    // Every product a_i a_j with i != j appears twice in its column, so sum them once and double
+    u64 carry = 0;
+    for (u32 k = 0; k + 1 < 2 * n; k++) {
+        u64 low = 0;
+        u64 high = 0;
+        for (u32 i = k < n ? 0 : k - n + 1; 2 * i < k; i++) {
+            u64 product = (u64) a[i] * a[k - i];
+            low += (u32) product;
+            high += product >> 32;
+        }
+        low = 2 * low + carry;
+        high = 2 * high;
+        if (k % 2 == 0) {
+            u64 product = (u64) a[k / 2] * a[k / 2];
+            low += (u32) product;
+            high += product >> 32;
+        }
+        result[k] = (u32) low;
+        carry = (low >> 32) + high;
+    }
+    result[2 * n - 1] = (u32) carry;
+}
+
+static void fixed_limbs_sum(const u32 *low, u32 low_count, const u32 *high, u32 high_count, u32 *result) {
+    // Requires low_count <= high_count, writes high_count + 1 limbs
+    u64 carry = 0;
+    for (u32 i = 0; i < high_count; i++) {
+        u64 current = (u64) high[i] + (i < low_count ? low[i] : 0) + carry;
+        result[i] = (u32) current;
+        carry = current >> 32;
+    }
+    result[high_count] = (u32) carry;
+}
+
+static void fixed_limbs_add(u32 *target, u32 target_count, const u32 *value, u32 count) {
+    u64 carry = 0;
+    for (u32 i = 0; i < target_count && (i < count || carry); i++) {
+        u64 current = (u64) target[i] + (i < count ? value[i] : 0) + carry;
+        target[i] = (u32) current;
+        carry = current >> 32;
+    }
+}
+
+static void fixed_limbs_sub(u32 *target, u32 target_count, const u32 *value, u32 count) {
+    u64 borrow = 0;
+    for (u32 i = 0; i < target_count && (i < count || borrow); i++) {
+        u64 current = (u64) target[i] - (i < count ? value[i] : 0) - borrow;
+        target[i] = (u32) current;
+        borrow = (current >> 32) != 0;
+    }
+}
+
+static void fixed_limbs_karatsuba(const u32 *a, const u32 *b, u32 n, u32 *result, u32 *scratch) {
+    // a b = z2 B^2 + z1 B + z0 with z1 = (a_0 + a_1) (b_0 + b_1) - z0 - z2, squares
+    // stay squares all the way down since a == b is passed on
+    if (n < FIXED_KARATSUBA_BASE) {
+        if (a == b) {
+            fixed_limbs_schoolbook_square(a, n, result);
+        } else {
+            fixed_limbs_schoolbook(a, b, n, result);
+        }
+        return;
+    }
+    u32 low = n / 2;
+    u32 high = n - low;
+    fixed_limbs_karatsuba(a, b, low, result, scratch);
+    fixed_limbs_karatsuba(a + low, b + low, high, result + 2 * low, scratch);
+
+    u32 m = high + 1;
+    u32 *sum_a = scratch;
+    u32 *sum_b = scratch + m;
+    u32 *middle = scratch + 2 * m;
+    fixed_limbs_sum(a, low, a + low, high, sum_a);
+    if (a == b) {
+        sum_b = sum_a;
+    } else {
+        fixed_limbs_sum(b, low, b + low, high, sum_b);
+    }
+    fixed_limbs_karatsuba(sum_a, sum_b, m, middle, scratch + 4 * m);
+    fixed_limbs_sub(middle, 2 * m, result, 2 * low);
+    fixed_limbs_sub(middle, 2 * m, result + 2 * low, 2 * high);
+    fixed_limbs_add(result + low, 2 * n - low, middle, 2 * m);
+}
+
+static void fixed_limbs_short(const u32 *a, const u32 *b, u32 n, u32 *result, u32 *scratch) {
+    // The upper half sum_{i + j >= n - 1} a_i b_j B^(i + j - n + 1) of the product, that
+    // is n limbs plus a carry limb. Mulders' short product takes the full product of the
+    // upper k limbs, the remaining cross terms are two short products of n - k limbs
+    if (n < FIXED_KARATSUBA_BASE) {
+        u64 carry = 0;
+        for (u32 k = n - 1; k + 1 < 2 * n; k++) {
+            u64 low = carry;
+            u64 high = 0;
+            for (u32 i = k - n + 1; i < n; i++) {
+                u64 product = (u64) a[i] * b[k - i];
+                low += (u32) product;
+                high += product >> 32;
+            }
+            result[k - n + 1] = (u32) low;
+            carry = (low >> 32) + high;
+        }
+        result[n] = (u32) carry;
+        return;
+    }
+    u32 l = 3 * n / 10;
+    u32 k = n - l;
+    u32 *full = scratch;
+    u32 *cross = scratch + 2 * k;
+    fixed_limbs_karatsuba(a + l, b + l, k, full, scratch + 2 * k);
+    memcpy(result, full + k - l - 1, (n + 1) * sizeof(u32));
+
+    fixed_limbs_short(a, b + k, l, cross, scratch + 2 * k + l + 1);
+    fixed_limbs_add(result, n + 1, cross, l + 1);
+    if (a != b) {
+        fixed_limbs_short(b, a + k, l, cross, scratch + 2 * k + l + 1);
+    }
+    fixed_limbs_add(result, n + 1, cross, l + 1);
+}
+
+// ===================================================================================
+// FIXED POINT
+// ===================================================================================
+
+void fixed_zero(fixed_t *self) {
+    memset(self->limbs, 0, sizeof self->limbs);
+    self->negative = false;
+}
+
+static s32 fixed_compare_magnitude(const fixed_t *a, const fixed_t *b, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        if (a->limbs[i] != b->limbs[i]) {
+            return a->limbs[i] < b->limbs[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void fixed_add_magnitude(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    u64 carry = 0;
+    for (u32 i = count; i-- > 0;) {
+        u64 sum = (u64) a->limbs[i] + b->limbs[i] + carry;
+        result->limbs[i] = (u32) sum;
+        carry = sum >> 32;
+    }
+}
+
+static void fixed_sub_magnitude(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    // Requires |a| >= |b|
+    s64 borrow = 0;
+    for (u32 i = count; i-- > 0;) {
+        s64 difference = (s64) a->limbs[i] - b->limbs[i] - borrow;
+        borrow = difference < 0;
+        result->limbs[i] = (u32) (difference + (borrow << 32));
+    }
+}
+
+static void fixed_add_signed(const fixed_t *a, const fixed_t *b, bool b_negative, fixed_t *result, u32 count) {
+    bool a_negative = a->negative;
+    if (a_negative == b_negative) {
+        fixed_add_magnitude(a, b, result, count);
+        result->negative = a_negative;
+    } else if (fixed_compare_magnitude(a, b, count) >= 0) {
+        fixed_sub_magnitude(a, b, result, count);
+        result->negative = a_negative;
+    } else {
+        fixed_sub_magnitude(b, a, result, count);
+        result->negative = b_negative;
+    }
+}
+
+void fixed_add(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    fixed_add_signed(a, b, b->negative, result, count);
+}
+
+void fixed_sub(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    fixed_add_signed(a, b, !b->negative, result, count);
+}
+
+static void fixed_mul_truncated(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    // Schoolbook multiplication, column by column from the least significant kept
+    // limb, all columns below the kept limbs are truncated
+    u32 columns[FIXED_MAX_LIMBS];
+    u64 carry = 0;
+    for (u32 k = count; k-- > 0;) {
+        u64 low = carry;
+        u64 high = 0;
+        for (u32 i = 0; i <= k; i++) {
+            u64 product = (u64) a->limbs[i] * b->limbs[k - i];
+            low += (u32) product;
+            high += product >> 32;
+        }
+        columns[k] = (u32) low;
+        carry = (low >> 32) + high;
+    }
+    memcpy(result->limbs, columns, count * sizeof(u32));
+}
+
+static void fixed_square_truncated(const fixed_t *a, fixed_t *result, u32 count) {
+    // Same as fixed_mul_truncated, but the symmetric products of a column are only
+    // computed once
+    u32 columns[FIXED_MAX_LIMBS];
+    u64 carry = 0;
+    for (u32 k = count; k-- > 0;) {
+        u64 low = 0;
+        u64 high = 0;
+        for (u32 i = 0; 2 * i < k; i++) {
+            u64 product = (u64) a->limbs[i] * a->limbs[k - i];
+            low += (u32) product;
+            high += product >> 32;
+        }
+        low = 2 * low + carry;
+        high = 2 * high;
+        if (k % 2 == 0) {
+            u64 product = (u64) a->limbs[k / 2] * a->limbs[k / 2];
+            low += (u32) product;
+            high += product >> 32;
+        }
+        columns[k] = (u32) low;
+        carry = (low >> 32) + high;
+    }
+    memcpy(result->limbs, columns, count * sizeof(u32));
+}
+
+static void fixed_mul_short(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    // Limbs reversed to little-endian, the value is scaled by B^(count - 1) for both
+    // factors, which is exactly what the short product drops. Clearing the copies costs
+    // nothing next to a product of at least FIXED_KARATSUBA_THRESHOLD limbs
+    u32 a_limbs[FIXED_MAX_LIMBS] = {0};
+    u32 b_limbs[FIXED_MAX_LIMBS] = {0};
+    u32 product[FIXED_MAX_LIMBS + 1];
+    u32 scratch[FIXED_SCRATCH_LIMBS];
+    for (u32 i = 0; i < count; i++) {
+        a_limbs[i] = a->limbs[count - 1 - i];
+    }
+    if (a == b) {
+        fixed_limbs_short(a_limbs, a_limbs, count, product, scratch);
+    } else {
+        for (u32 i = 0; i < count; i++) {
+            b_limbs[i] = b->limbs[count - 1 - i];
+        }
+        fixed_limbs_short(a_limbs, b_limbs, count, product, scratch);
+    }
+    for (u32 i = 0; i < count; i++) {
+        result->limbs[i] = product[count - 1 - i];
+    }
+}
+
+void fixed_mul(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    bool negative = a->negative != b->negative;
+    if (count < FIXED_KARATSUBA_THRESHOLD) {
+        fixed_mul_truncated(a, b, result, count);
+    } else {
+        fixed_mul_short(a, b, result, count);
+    }
+    result->negative = negative;
+}
+
+void fixed_square(const fixed_t *a, fixed_t *result, u32 count) {
+    if (count < FIXED_KARATSUBA_THRESHOLD) {
+        fixed_square_truncated(a, result, count);
+    } else {
+        fixed_mul_short(a, a, result, count);
+    }
+    result->negative = false;
+}
+
+void fixed_mandelbrot_step(fixed_t *z_x, fixed_t *z_y, const fixed_t *c_x, const fixed_t *c_y, u32 count) {
+    fixed_t xx, yy, sum;
+    fixed_square(z_x, &xx, count);
+    fixed_square(z_y, &yy, count);
+    fixed_add(z_x, z_y, &sum, count);
+    fixed_square(&sum, &sum, count);
+
+    // y' = (x + y)^2 - x^2 - y^2 + c_y, x' = x^2 - y^2 + c_x
+    fixed_sub(&sum, &xx, &sum, count);
+    fixed_sub(&sum, &yy, &sum, count);
+    fixed_add(&sum, c_y, z_y, count);
+    fixed_sub(&xx, &yy, z_x, count);
+    fixed_add(z_x, c_x, z_x, count);
+}
+
+// ===================================================================================
+// CONVERSION
+// ===================================================================================
+
+void fixed_from_f64(fixed_t *self, f64 value) {
+    fixed_zero(self);
+    self->negative = value < 0.0;
+    value = fabs(value);
+    for (u32 i = 0; i < FIXED_MAX_LIMBS && value != 0.0; i++) {
+        f64 limb = floor(value);
+        self->limbs[i] = (u32) limb;
+        value = (value - limb) * 4294967296.0;
+    }
+}
+
+f64 fixed_to_f64(const fixed_t *self, u32 count) {
+    u32 first = 0;
+    while (first < count && self->limbs[first] == 0) {
+        first++;
+    }
+    if (first == count) {
+        return 0.0;
+    }
+
+    // The 64 bits from the leading one on become the mantissa, every bit beyond them is
+    // folded into the lowest one. That is far below the rounding position, but breaks
+    // ties the way the exact value would when the integer is converted
+    u32 shift = 0;
+    while ((self->limbs[first] << shift & 0x80000000u) == 0) {
+        shift++;
+    }
+    u64 high = (u64) self->limbs[first] << 32 | (first + 1 < count ? self->limbs[first + 1] : 0);
+    u32 low = first + 2 < count ? self->limbs[first + 2] : 0;
+    u64 mantissa = shift ? high << shift | low >> (32 - shift) : high;
+    bool sticky = (u32) (low << shift) != 0;
+    for (u32 i = first + 3; i < count && !sticky; i++) {
+        sticky = self->limbs[i] != 0;
+    }
+    f64 result = ldexp((f64) (mantissa | sticky), -32 * (s32) first - 32 - (s32) shift);
+    return self->negative ? -result : result;
+}
+
+bool fixed_from_string(fixed_t *self, const char *string) {
+    fixed_zero(self);
+    bool negative = false;
+    if (*string == '-' || *string == '+') {
+        negative = *string == '-';
+        string++;
+    }
+
+    // At least one digit has to be on either side of the point
+    const char *start = string;
+    u64 integer = 0;
+    while (*string >= '0' && *string <= '9') {
+        integer = integer * 10 + (u64) (*string - '0');
+        if (integer > UINT32_MAX) {
+            return false;
+        }
+        string++;
+    }
+
+    bool digits_found = string > start;
+    if (*string == '.') {
+        string++;
+        const char *digits = string;
+        while (*string >= '0' && *string <= '9') {
+            string++;
+        }
+        digits_found = digits_found || string > digits;
+
+        // Horner's scheme from the last digit: fraction = (digit + fraction) / 10
+        for (const char *digit = string; digit-- > digits;) {
+            self->limbs[0] = (u32) (*digit - '0');
+            u64 remainder = 0;
+            for (u32 i = 0; i < FIXED_MAX_LIMBS; i++) {
+                u64 current = (remainder << 32) | self->limbs[i];
+                self->limbs[i] = (u32) (current / 10);
+                remainder = current % 10;
+            }
+        }
+    }
+    if (*string != '\0' || !digits_found) {
+        return false;
+    }
+    self->limbs[0] = (u32) integer;
+    self->negative = negative;
+    return true;
+}
@@ -0,0 +1,131 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_FIXED_H
+#define LIBFRACTAL_FIXED_H
+
+#include "types.h"
+
+// Up to 32768 bits, enough for reference orbits and nucleus searches far beyond double range
+#define FIXED_MAX_LIMBS 1024
+
+// Products of at least this many limbs use a Karatsuba based short product
+#define FIXED_KARATSUBA_THRESHOLD 256
+
+/**
+ * Fixed point number with 32 bit limbs in sign-magnitude representation, the most
+ * significant limb holds the integer part, all other limbs are fractional. Every
+ * operation takes the number of limbs it works on, limbs beyond that are ignored.
+ */
+typedef struct fixed {
+    u32 limbs[FIXED_MAX_LIMBS];
+    bool negative;
+} fixed_t;
+
+/**
+ * Sets the number to zero
+ *
+ * @param self fixed handle
+ */
+void fixed_zero(fixed_t *self);
+
+/**
+ * Converts a double exactly as far as the limbs reach
+ *
+ * @param self fixed handle
+ * @param value value, its integer part has to fit into 32 bits
+ */
+void fixed_from_f64(fixed_t *self, f64 value);
+
+/**
+ * Rounds the number to the nearest double, ties to even. Numbers below the smallest
+ * normal double lose precision and end up as zero far enough below it.
+ *
+ * @param self fixed handle
+ * @param count number of limbs
+ * @return value
+ */
+f64 fixed_to_f64(const fixed_t *self, u32 count);
+
+/**
+ * Parses a decimal string such as "-0.7436438870371587047521915"
+ *
+ * @param self fixed handle
+ * @param string decimal string
+ * @return false if the string is not a decimal number or its integer part exceeds 32 bits
+ */
+bool fixed_from_string(fixed_t *self, const char *string);
+
+/**
+ * Adds two numbers, result may alias either summand
+ *
+ * @param a first summand
+ * @param b second summand
+ * @param result a + b
+ * @param count number of limbs
+ */
+void fixed_add(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count);
+
+/**
+ * Subtracts two numbers, result may alias either operand
+ *
+ * @param a minuend
+ * @param b subtrahend
+ * @param result a - b
+ * @param count number of limbs
+ */
+void fixed_sub(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count);
+
+/**
+ * Multiplies two numbers, the product is truncated to count limbs and result may
+ * alias either factor
+ *
+ * @param a first factor
+ * @param b second factor
+ * @param result a * b
+ * @param count number of limbs
+ */
+void fixed_mul(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count);
+
+/**
+ * Squares a number, which takes about half the work of fixed_mul
+ *
+ * @param a number
+ * @param result a * a
+ * @param count number of limbs
+ */
+void fixed_square(const fixed_t *a, fixed_t *result, u32 count);
+
+/**
+ * Advances z to z^2 + c with three squarings, using 2 x y = (x + y)^2 - x^2 - y^2
+ *
+ * @param z_x real part of z
+ * @param z_y imaginary part of z
+ * @param c_x real part of c
+ * @param c_y imaginary part of c
+ * @param count number of limbs
+ */
+void fixed_mandelbrot_step(fixed_t *z_x, fixed_t *z_y, const fixed_t *c_x, const fixed_t *c_y, u32 count);
+
+#endif// LIBFRACTAL_FIXED_H
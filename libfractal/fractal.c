@@ -23,8 +23,8 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "fractal.h"
-#include "math.h"
 
 // ===================================================================================
 // SHADER SOURCE MACRO HELPERS
@@ -42,16 +42,10 @@
 
 DEFINE_SHADER(shader_vertex,
 layout(location = 0) in vec4 attrib_position;
-layout(location = 0) out vec4 passed_position;
-
-// matrix for transforming fragments into mandelbrot space
-uniform mat4 uniform_fractal_scale;
 
 void main() {
-    // the inverse of the scale matrix is used,
-    // as we take in normalized coordinates
-    // which we want to transform into the mandelbrot space
-    passed_position = inverse(uniform_fractal_scale) * attrib_position;
+    // the fragments map themselves into the mandelbrot space
+    // through their window coordinates, see the fragment shader
     gl_Position = attrib_position;
 });
 
@@ -60,13 +54,31 @@ void main() {
 // ===================================================================================
 
 DEFINE_SHADER(shader_fragment,
-layout(location = 0) out vec4 output_color;
-layout(location = 0) in vec4 passed_position;
+layout(location = 0) out float output_value;
+
+// view of the mandelbrot space, see fractal_view_t
+uniform vec2 uniform_center;
+uniform float uniform_scale;
+uniform vec2 uniform_size;
+uniform int uniform_max_iterations;
+uniform int uniform_distance;
 
-vec4 mandelbrot(vec2 c) {
+// points inside the main cardioid or the period-2 bulb never escape
+bool interior(vec2 c) {
+    float xq = c.x - 0.25;
+    float yy = c.y * c.y;
+    float q = xq * xq + yy;
+    float bulb = (c.x + 1) * (c.x + 1) + yy;
+    return q * (q + xq) < 0.25 * yy || bulb < 0.0625;
+}
+
+// iteration count of escaped points, -1 for the others, see fractal_cpu_value
+float mandelbrot(vec2 c) {
+    if (interior(c)) {
+        return -1.0;
+    }
     int iteration = 0;
-    int max_iterations = 50;
-    for (vec2 z = vec2(0); iteration < max_iterations; ++iteration) {
+    for (vec2 z = vec2(0); iteration < uniform_max_iterations; ++iteration) {
         float x = z.x * z.x - z.y * z.y;
         float y = 2 * z.x * z.y;
         if (x * x + y * y > 4) {
@@ -75,18 +87,135 @@ vec4 mandelbrot(vec2 c) {
         z.x = x + c.x;
         z.y = y + c.y;
     }
-    if (iteration < max_iterations) {
-        float t = float(iteration) / float(max_iterations);
-        float r = 9.0 * (1.0 - t) * t * t * t;
-        float g = 15.0 * (1.0 - t) * (1.0 - t) * t * t;
-        float b = 8.5 * (1.0 - t) * (1.0 - t) * (1.0 - t) * t;
-        return vec4(r, g, b, 1.0);
+    return iteration < uniform_max_iterations ? float(iteration) : -1.0;
+}
+
+// exterior distance estimate from the derivative dz' = 2 z dz + 1, see kernel_distance_t
+float exterior_distance(vec2 c) {
+    if (interior(c)) {
+        return -1.0;
+    }
+    int iteration = 0;
+    vec2 z = vec2(0);
+    vec2 dz = vec2(0);
+    for (; iteration < uniform_max_iterations; ++iteration) {
+        if (dot(z, z) > 65536.0) {
+            break;
+        }
+        dz = 2 * vec2(z.x * dz.x - z.y * dz.y, z.x * dz.y + z.y * dz.x) + vec2(1.0, 0.0);
+        z = vec2(z.x * z.x - z.y * z.y, 2 * z.x * z.y) + c;
+    }
+    if (iteration < uniform_max_iterations) {
+        // the distance in pixels
+        return length(z) * log(length(z)) / length(dz) / uniform_scale;
+    }
+    return -1.0;
+}
+
+void main() {
+    vec2 c = uniform_center + (gl_FragCoord.xy - 0.5 * uniform_size) * uniform_scale;
+    output_value = uniform_distance != 0 ? exterior_distance(c) : mandelbrot(c);
+});
+
+// ===================================================================================
+// DOUBLE PRECISION FRAGMENT SHADER SOURCE
+// ===================================================================================
+
+DEFINE_SHADER(shader_fragment_f64,
+layout(location = 0) out float output_value;
+
+// view of the mandelbrot space, see fractal_view_t
+uniform dvec2 uniform_center;
+uniform double uniform_scale;
+uniform vec2 uniform_size;
+uniform int uniform_max_iterations;
+uniform int uniform_distance;
+
+// points inside the main cardioid or the period-2 bulb never escape
+bool interior(dvec2 c) {
+    double xq = c.x - 0.25;
+    double yy = c.y * c.y;
+    double q = xq * xq + yy;
+    double bulb = (c.x + 1) * (c.x + 1) + yy;
+    return q * (q + xq) < 0.25 * yy || bulb < 0.0625;
+}
+
+// iteration count of escaped points, -1 for the others, see fractal_cpu_value
+float mandelbrot(dvec2 c) {
+    if (interior(c)) {
+        return -1.0;
+    }
+    int iteration = 0;
+    for (dvec2 z = dvec2(0); iteration < uniform_max_iterations; ++iteration) {
+        double x = z.x * z.x - z.y * z.y;
+        double y = 2 * z.x * z.y;
+        if (x * x + y * y > 4) {
+            break;
+        }
+        z.x = x + c.x;
+        z.y = y + c.y;
+    }
+    return iteration < uniform_max_iterations ? float(iteration) : -1.0;
+}
+
+// exterior distance estimate from the derivative dz' = 2 z dz + 1, see kernel_distance_t
+float exterior_distance(dvec2 c) {
+    if (interior(c)) {
+        return -1.0;
+    }
+    int iteration = 0;
+    dvec2 z = dvec2(0);
+    dvec2 dz = dvec2(0);
+    for (; iteration < uniform_max_iterations; ++iteration) {
+        if (dot(z, z) > 65536.0) {
+            break;
+        }
+        dz = 2 * dvec2(z.x * dz.x - z.y * dz.y, z.x * dz.y + z.y * dz.x) + dvec2(1.0, 0.0);
+        z = dvec2(z.x * z.x - z.y * z.y, 2 * z.x * z.y) + c;
     }
-    return vec4(0.0);
+    if (iteration < uniform_max_iterations) {
+        // there are no double precision logarithms, the ratio is taken in doubles first
+        return float(length(z) / length(dz) / uniform_scale) * log(float(length(z)));
+    }
+    return -1.0;
 }
 
 void main() {
-    output_color = mandelbrot(passed_position.xy);
+    dvec2 c = uniform_center + dvec2(gl_FragCoord.xy - 0.5 * uniform_size) * uniform_scale;
+    output_value = uniform_distance != 0 ? exterior_distance(c) : mandelbrot(c);
+});
+
+// ===================================================================================
+// COLOR FRAGMENT SHADER SOURCE
+// ===================================================================================
+
+DEFINE_SHADER(shader_fragment_color,
+layout(location = 0) out vec4 output_color;
+
+// values of the iteration pass or the cpu renderer, one texel per pixel starting at the bottom row
+uniform sampler2D uniform_values;
+uniform int uniform_max_iterations;
+uniform int uniform_distance;
+
+// palette, see fractal_palette_t
+uniform vec3 uniform_weights;
+uniform float uniform_density;
+
+void main() {
+    float value = texelFetch(uniform_values, ivec2(gl_FragCoord.xy), 0).r;
+    if (value < 0.0) {
+        output_color = vec4(0.0);
+    } else if (uniform_distance != 0) {
+        // the distance in pixels, full brightness at FRACTAL_CPU_DISTANCE_RANGE
+        float t = min(1.0, sqrt(value / 16.0));
+        output_color = vec4(t, t, t, 1.0);
+    } else {
+        float t = fract(uniform_density * value / float(uniform_max_iterations));
+        float r = uniform_weights.r * (1.0 - t) * t * t * t;
+        float g = uniform_weights.g * (1.0 - t) * (1.0 - t) * t * t;
+        float b = uniform_weights.b * (1.0 - t) * (1.0 - t) * (1.0 - t) * t;
+        output_color = vec4(r, g, b, 1.0);
+    }
 });
 
 // ===================================================================================
@@ -111,6 +240,31 @@ void fractal_pipeline_create(fractal_pipeline_t *self) {
 
     shader_create(&self->shader, shader_vertex, shader_fragment);
 
+    // Double precision is core since OpenGL 4.0, but drivers may still refuse it
+    self->shader_f64_supported = shader_create(&self->shader_f64, shader_vertex, shader_fragment_f64);
+    if (!self->shader_f64_supported) {
+        fprintf(stderr, "[fractal] no double precision shader, deep zooms will lose precision\n");
+    }
+    self->precision = FRACTAL_PRECISION_F32;
+    self->distance = false;
+
+    // The iteration shaders render values into a texture, which the color pass turns into the
+    // image. Values of the cpu renderer go through the same color pass
+    texture_create(&self->values);
+    framebuffer_create(&self->framebuffer);
+    framebuffer_texture(&self->framebuffer, &self->values);
+    self->values_valid = false;
+    shader_create(&self->shader_color, shader_vertex, shader_fragment_color);
+    shader_uniform_sampler(&self->shader_color, "uniform_values", 0);
+    self->palette = FRACTAL_PALETTE_DEFAULT;
+    texture_create(&self->texture);
+    refine_create(&self->refine);
+    cache_create(&self->cache, CACHE_BUDGET_DEFAULT);
+    const char *store = getenv(STORE_ENVIRONMENT);
+    if (store && *store && store_open(&self->store, store, STORE_BUDGET_DEFAULT)) {
+        cache_attach(&self->cache, &self->store);
+    }
+
     // Two triangles are the drawing surface of our computation shader
     static vertex_t vertices[] = {
             {{1.0f,  -1.0f, 0.0f, 1.0f}},
@@ -126,22 +280,128 @@ void fractal_pipeline_create(fractal_pipeline_t *self) {
 }
 
 void fractal_pipeline_destroy(fractal_pipeline_t *self) {
+    bool persistent = self->cache.store != NULL;
+    cache_destroy(&self->cache);
+    if (persistent) {
+        store_close(&self->store);
+    }
+    refine_destroy(&self->refine);
+    texture_destroy(&self->texture);
+    shader_destroy(&self->shader_color);
+    framebuffer_destroy(&self->framebuffer);
+    texture_destroy(&self->values);
+    if (self->shader_f64_supported) {
+        shader_destroy(&self->shader_f64);
+    }
     shader_destroy(&self->shader);
     index_buffer_destroy(&self->index_buffer);
     vertex_buffer_destroy(&self->vertex_buffer);
     vertex_array_destroy(&self->vertex_array);
 }
 
-void fractal_pipeline_submit(fractal_pipeline_t *self, u32 width, u32 height) {
-    // Viewport aspect ratio determines scale of fractal
-    f32 ratio = (f32) width / (f32) height;
-    f32mat4_t scale;
-    f32mat4_create_orthogonal(&scale, -2.0f * ratio, 0.47f * ratio, -1.12f, 1.12f);
-    shader_uniform_f32mat4(&self->shader, "uniform_fractal_scale", &scale);
+static void fractal_pipeline_iterate(fractal_pipeline_t *self, const fractal_view_t *view) {
+    // Switch to doubles once the pixel spacing gets close to the float epsilon
+    // Double-double is only available on the cpu, doubles are the best the gpu can do
+    fractal_precision_t precision = fractal_view_precision(view);
+    if (precision > FRACTAL_PRECISION_F64) {
+        precision = FRACTAL_PRECISION_F64;
+    }
+    if (!self->shader_f64_supported) {
+        precision = FRACTAL_PRECISION_F32;
+    }
+    self->precision = precision;
+
+    shader_t *shader = &self->shader;
+    f32vec2_t size = {(f32) view->width, (f32) view->height};
+    if (precision == FRACTAL_PRECISION_F32) {
+        f32vec2_t center = {(f32) view->center_x, (f32) view->center_y};
+        shader_uniform_f32vec2(shader, "uniform_center", &center);
+        shader_uniform_f32(shader, "uniform_scale", (f32) view->scale);
+    } else {
+        shader = &self->shader_f64;
+        f64vec2_t center = {view->center_x, view->center_y};
+        shader_uniform_f64vec2(shader, "uniform_center", &center);
+        shader_uniform_f64(shader, "uniform_scale", view->scale);
+    }
+    shader_uniform_f32vec2(shader, "uniform_size", &size);
+    shader_uniform_s32(shader, "uniform_max_iterations", (s32) view->max_iterations);
+    shader_uniform_s32(shader, "uniform_distance", self->distance);
+
+    // Output to the values texture
+    texture_storage(&self->values, view->width, view->height, TEXTURE_R32F);
+    framebuffer_bind(&self->framebuffer);
+    shader_bind(shader);
+    vertex_array_bind(&self->vertex_array);
+    glDrawElements(GL_TRIANGLES, (GLsizei) self->vertex_array.index_buffer->count, GL_UNSIGNED_INT, NULL);
+    vertex_array_unbind();
+    framebuffer_unbind();
+}
+
+static void fractal_pipeline_color(fractal_pipeline_t *self, texture_t *values, u32 max_iterations, bool distance) {
+    // One texel fetch and the palette per pixel
+    shader_t *shader = &self->shader_color;
+    shader_uniform_s32(shader, "uniform_max_iterations", (s32) max_iterations);
+    shader_uniform_s32(shader, "uniform_distance", distance);
+    shader_uniform_f32vec3(shader, "uniform_weights", &self->palette.weights);
+    shader_uniform_f32(shader, "uniform_density", self->palette.density);
 
     // Output to the gpu
-    shader_bind(&self->shader);
+    shader_bind(shader);
+    texture_bind(values, 0);
     vertex_array_bind(&self->vertex_array);
     glDrawElements(GL_TRIANGLES, (GLsizei) self->vertex_array.index_buffer->count, GL_UNSIGNED_INT, NULL);
     vertex_array_unbind();
+    texture_unbind(0);
+}
+
+void fractal_pipeline_submit(fractal_pipeline_t *self, const fractal_view_t *view) {
+    // The iteration pass only runs when the view changed, a new palette is just a color pass
+    if (!self->values_valid || !fractal_view_equal(&self->values_view, view)) {
+        fractal_pipeline_iterate(self, view);
+        self->values_view = *view;
+        self->values_valid = true;
+    }
+    fractal_pipeline_color(self, &self->values, view->max_iterations, self->distance);
+}
+
+void fractal_pipeline_distance(fractal_pipeline_t *self, bool enabled) {
+    // Distances and iteration counts are different values
+    self->values_valid = self->values_valid && self->distance == enabled;
+    self->distance = enabled;
+}
+
+void fractal_pipeline_palette(fractal_pipeline_t *self, const fractal_palette_t *palette) {
+    self->palette = *palette;
+}
+
+void fractal_pipeline_cache(fractal_pipeline_t *self, u64 budget) {
+    // The store keeps what the previous cache persisted
+    store_t *store = self->cache.store;
+    cache_destroy(&self->cache);
+    cache_create(&self->cache, budget);
+    cache_attach(&self->cache, store);
+}
+
+bool fractal_pipeline_refine(fractal_pipeline_t *self, thread_pool_t *pool, const fractal_view_t *view) {
+    // A view panned by whole pixels or zoomed along the pixel lattice keeps its samples, any
+    // other change starts over unless the cache knows the view. A reused view is presented as
+    // is for one frame, which shows the upsampled preview of a zoom. The texture is only
+    // updated when pixels changed, complete views go to the cache then
+    bool reused = false;
+    if (self->refine.iterations == NULL || !fractal_view_equal(&self->refine.view, view)) {
+        reused = refine_translate(&self->refine, pool, view) || refine_zoom(&self->refine, pool, view);
+        if (!reused) {
+            refine_reset(&self->refine, view);
+            reused = refine_load(&self->refine, pool, &self->cache);
+        }
+    }
+    bool evaluated = !reused && refine_step(&self->refine, pool);
+    if ((reused || evaluated) && refine_complete(&self->refine)) {
+        cache_store(&self->cache, view, self->refine.iterations);
+    }
+    if (reused || evaluated) {
+        texture_data(&self->texture, view->width, view->height, TEXTURE_R32F, self->refine.values);
+    }
+    fractal_pipeline_color(self, &self->texture, self->refine.view.max_iterations, false);
+    return !refine_complete(&self->refine);
 }
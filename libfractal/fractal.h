@@ -26,16 +26,50 @@
 #define LIBFRACTAL_FRACTAL_H
 
 #include "gpu.h"
+#include "refine.h"
+#include "store.h"
+#include "thread.h"
+#include "view.h"
+
+/**
+ * Palette of the color pass. A point that escapes after n iterations is colored by the
+ * polynomials of t = fract(density n / max_iterations) that fractal_cpu_color uses, with the
+ * red, green and blue terms scaled by weights
+ */
+typedef struct fractal_palette {
+    f32vec3_t weights;
+    f32 density;
+} fractal_palette_t;
+
+/**
+ * Palette of the original shader, see fractal_cpu_color
+ */
+#define FRACTAL_PALETTE_DEFAULT ((fractal_palette_t) {{9.0f, 15.0f, 8.5f}, 1.0f})
 
 typedef struct fractal_pipeline {
     vertex_array_t vertex_array;
     vertex_buffer_t vertex_buffer;
     index_buffer_t index_buffer;
     shader_t shader;
+    shader_t shader_f64;
+    bool shader_f64_supported;
+    fractal_precision_t precision;
+    bool distance;
+    texture_t values;
+    framebuffer_t framebuffer;
+    fractal_view_t values_view;
+    bool values_valid;
+    shader_t shader_color;
+    fractal_palette_t palette;
+    texture_t texture;
+    refine_t refine;
+    cache_t cache;
+    store_t store;
 } fractal_pipeline_t;
 
 /**
- * Creates a new fractal pipeline
+ * Creates a new fractal pipeline, the tile cache is persisted in the directory named by
+ * STORE_ENVIRONMENT if it is set
  *
  * @param self pipeline handle
  */
@@ -49,12 +83,57 @@ void fractal_pipeline_create(fractal_pipeline_t *self);
 void fractal_pipeline_destroy(fractal_pipeline_t *self);
 
 /**
- * Submit the pipeline state to the gpu
+ * Submit the pipeline state to the gpu, the view is rendered in double precision
+ * if it is zoomed in too far for single precision and the gpu supports it. The iteration
+ * pass renders raw iteration counts into a texture and only runs for a changed view, the
+ * color pass applies the palette to them on every submit. The precision the gpu used is left
+ * in the precision field of the pipeline.
+ *
+ * @param self pipeline handle
+ * @param view view handle
+ */
+void fractal_pipeline_submit(fractal_pipeline_t *self, const fractal_view_t *view);
+
+/**
+ * Switches fractal_pipeline_submit between escape time coloring and the exterior distance
+ * estimate, which shades pixels by their distance to the set like fractal_cpu_color_distance
+ *
+ * @param self pipeline handle
+ * @param enabled whether to render distances
+ */
+void fractal_pipeline_distance(fractal_pipeline_t *self, bool enabled);
+
+/**
+ * Replaces the tile cache of the cpu renderer with an empty one of the specified budget, the
+ * store stays attached
+ *
+ * @param self pipeline handle
+ * @param budget memory budget in bytes, see cache_create
+ */
+void fractal_pipeline_cache(fractal_pipeline_t *self, u64 budget);
+
+/**
+ * Sets the palette of the color pass, the iterations are not computed again
+ *
+ * @param self pipeline handle
+ * @param palette palette handle
+ */
+void fractal_pipeline_palette(fractal_pipeline_t *self, const fractal_palette_t *palette);
+
+/**
+ * Renders the view progressively on the cpu and presents the current level. A changed view
+ * starts over at the coarsest level which is on screen right away, every further call
+ * evaluates the next finer level until the view is complete, see refine_t. A complete view
+ * that is panned by whole pixels only evaluates the exposed strips, a complete view zoomed
+ * along the pixel lattice only the missing samples, see refine_translate and refine_zoom.
+ * Complete views on the global lattice are kept in the tile cache, a view that is mostly
+ * cached is complete right away, see refine_load.
  *
  * @param self pipeline handle
- * @param width viewport width
- * @param height viewport height
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @param view view handle
+ * @return true while finer levels are left
  */
-void fractal_pipeline_submit(fractal_pipeline_t *self, u32 width, u32 height);
+bool fractal_pipeline_refine(fractal_pipeline_t *self, thread_pool_t *pool, const fractal_view_t *view);
 
 #endif// LIBFRACTAL_FRACTAL_H
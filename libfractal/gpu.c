@@ -159,6 +159,16 @@ void shader_uniform_f32vec4(shader_t* self, const char* name, f32vec4_t* value)
     glUniform4f(glGetUniformLocation(self->handle, name), value->x, value->y, value->z, value->w);
 }
 
+void shader_uniform_f64(shader_t* self, const char* name, f64 value) {
+    glUseProgram(self->handle);
+    glUniform1d(glGetUniformLocation(self->handle, name), value);
+}
+
+void shader_uniform_f64vec2(shader_t* self, const char* name, f64vec2_t* value) {
+    glUseProgram(self->handle);
+    glUniform2d(glGetUniformLocation(self->handle, name), value->x, value->y);
+}
+
 void shader_uniform_f32mat4(shader_t* self, const char* name, f32mat4_t* value) {
     glUseProgram(self->handle);
     glUniformMatrix4fv(glGetUniformLocation(self->handle, name), 1, GL_FALSE, &value->value[0].x);
@@ -356,3 +366,104 @@ void vertex_array_bind(vertex_array_t *self) {
 void vertex_array_unbind() {
     glBindVertexArray(0);
 }
+
+// ===================================================================================
+// TEXTURE
+// ===================================================================================
+
+void texture_create(texture_t *self) {
+    self->handle = 0;
+    self->width = 0;
+    self->height = 0;
+    glGenTextures(1, &self->handle);
+    glBindTexture(GL_TEXTURE_2D, self->handle);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void texture_destroy(texture_t *self) {
+    glDeleteTextures(1, &self->handle);
+}
+
+static void texture_format_opengl(texture_format_t format, GLint *internal, GLenum *layout, GLenum *type) {
+    switch (format) {
+        case TEXTURE_R32F:
+            *internal = GL_R32F;
+            *layout = GL_RED;
+            *type = GL_FLOAT;
+            break;
+        case TEXTURE_RGBA32F:
+        default:
+            *internal = GL_RGBA32F;
+            *layout = GL_RGBA;
+            *type = GL_FLOAT;
+            break;
+    }
+}
+
+void texture_data(texture_t *self, u32 width, u32 height, texture_format_t format, const void *data) {
+    GLint internal;
+    GLenum layout, type;
+    texture_format_opengl(format, &internal, &layout, &type);
+    glBindTexture(GL_TEXTURE_2D, self->handle);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (width != self->width || height != self->height) {
+        glTexImage2D(GL_TEXTURE_2D, 0, internal, (GLsizei) width, (GLsizei) height, 0, layout, type, data);
+        self->width = width;
+        self->height = height;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei) width, (GLsizei) height, layout, type, data);
+    }
+}
+
+void texture_storage(texture_t *self, u32 width, u32 height, texture_format_t format) {
+    if (width == self->width && height == self->height) {
+        return;
+    }
+    GLint internal;
+    GLenum layout, type;
+    texture_format_opengl(format, &internal, &layout, &type);
+    glBindTexture(GL_TEXTURE_2D, self->handle);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal, (GLsizei) width, (GLsizei) height, 0, layout, type, NULL);
+    self->width = width;
+    self->height = height;
+}
+
+void texture_bind(texture_t *self, u32 slot) {
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_2D, self->handle);
+}
+
+void texture_unbind(u32 slot) {
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// ===================================================================================
+// FRAMEBUFFER
+// ===================================================================================
+
+void framebuffer_create(framebuffer_t *self) {
+    self->handle = 0;
+    glGenFramebuffers(1, &self->handle);
+}
+
+void framebuffer_destroy(framebuffer_t *self) {
+    glDeleteFramebuffers(1, &self->handle);
+}
+
+void framebuffer_texture(framebuffer_t *self, texture_t *texture) {
+    glBindFramebuffer(GL_FRAMEBUFFER, self->handle);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->handle, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void framebuffer_bind(framebuffer_t *self) {
+    glBindFramebuffer(GL_FRAMEBUFFER, self->handle);
+}
+
+void framebuffer_unbind(void) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
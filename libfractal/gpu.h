@@ -133,6 +133,24 @@ void shader_uniform_f32vec3(shader_t *self, const char *name, f32vec3_t *value);
  */
 void shader_uniform_f32vec4(shader_t *self, const char *name, f32vec4_t *value);
 
+/**
+ * Sets a double (f64) uniform
+ *
+ * @param self shader handle
+ * @param name uniform name
+ * @param value value
+ */
+void shader_uniform_f64(shader_t *self, const char *name, f64 value);
+
+/**
+ * Sets a 2d-double (f64vec2_t) uniform
+ *
+ * @param self shader handle
+ * @param name uniform name
+ * @param value value
+ */
+void shader_uniform_f64vec2(shader_t *self, const char *name, f64vec2_t *value);
+
 /**
  * Sets a mat4 (f32mat4_t) uniform
  *
@@ -310,4 +328,111 @@ void vertex_array_bind(vertex_array_t *self);
  */
 void vertex_array_unbind(void);
 
+// ===================================================================================
+// TEXTURE
+// ===================================================================================
+
+typedef enum texture_format {
+    TEXTURE_RGBA32F = 0, TEXTURE_R32F
+} texture_format_t;
+
+typedef struct texture {
+    u32 handle;
+    u32 width;
+    u32 height;
+} texture_t;
+
+/**
+ * Creates an empty two dimensional texture, texels are sampled without any filtering
+ *
+ * @param self texture handle
+ */
+void texture_create(texture_t *self);
+
+/**
+ * Destroys the specified texture
+ *
+ * @param self texture handle
+ */
+void texture_destroy(texture_t *self);
+
+/**
+ * Sets the texels of the texture, the storage is only reallocated if the size changes
+ *
+ * @param self texture handle
+ * @param width width in texels
+ * @param height height in texels
+ * @param format format of the texels
+ * @param data pointer to the first texel of the bottom row
+ */
+void texture_data(texture_t *self, u32 width, u32 height, texture_format_t format, const void *data);
+
+/**
+ * Allocates uninitialized texels for the texture to be rendered to, the storage is only
+ * reallocated if the size changes
+ *
+ * @param self texture handle
+ * @param width width in texels
+ * @param height height in texels
+ * @param format format of the texels
+ */
+void texture_storage(texture_t *self, u32 width, u32 height, texture_format_t format);
+
+/**
+ * Binds the specified texture to a sampler slot
+ *
+ * @param self texture handle
+ * @param slot sampler slot
+ */
+void texture_bind(texture_t *self, u32 slot);
+
+/**
+ * Unbinds the texture of the specified sampler slot
+ *
+ * @param slot sampler slot
+ */
+void texture_unbind(u32 slot);
+
+// ===================================================================================
+// FRAMEBUFFER
+// ===================================================================================
+
+typedef struct framebuffer {
+    u32 handle;
+} framebuffer_t;
+
+/**
+ * Creates a framebuffer without any attachments
+ *
+ * @param self framebuffer handle
+ */
+void framebuffer_create(framebuffer_t *self);
+
+/**
+ * Destroys the specified framebuffer, the attached texture is kept
+ *
+ * @param self framebuffer handle
+ */
+void framebuffer_destroy(framebuffer_t *self);
+
+/**
+ * Makes the texture the color target of the framebuffer, the texture needs storage first
+ *
+ * @param self framebuffer handle
+ * @param texture texture handle
+ */
+void framebuffer_texture(framebuffer_t *self, texture_t *texture);
+
+/**
+ * Binds the specified framebuffer, draw calls render to its texture afterwards
+ *
+ * @param self framebuffer handle
+ */
+void framebuffer_bind(framebuffer_t *self);
+
+/**
+ * Binds the default framebuffer of the window again
+ */
+void framebuffer_unbind(void);
+
 #endif// LIBFRACTAL_GPU_H
@@ -0,0 +1,450 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define KERNEL_X86
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define KERNEL_X86
+#endif
+
+// ===================================================================================
+// SCALAR KERNEL
+// ===================================================================================
+
+bool kernel_interior(f64 cx, f64 cy, f64 margin) {
+    // Cardioid q (q + x - 1/4) < y^2 / 4 with q = (x - 1/4)^2 + y^2, bulb (x + 1)^2 + y^2 < 1/16
+    f64 xq = cx - 0.25;
+    f64 yy = cy * cy;
+    f64 q = xq * xq + yy;
+    f64 bulb = (cx + 1.0) * (cx + 1.0) + yy;
+    return q * (q + xq) < 0.25 * yy - margin || bulb < 0.0625 - margin;
+}
+
+static void kernel_scalar_f32(const f32 *cx, const f32 *cy, u32 count, u32 max_iterations, u32 checks,
+                              u32 *iterations, kernel_stats_t *stats) {
+    // Same steps as fractal_cpu_iterate, plus the interior checks
+    for (u32 i = 0; i < count; i++) {
+        if (fractal_cpu_interior(cx[i], cy[i])) {
+            iterations[i] = max_iterations;
+            stats->rejected++;
+            continue;
+        }
+        u32 iteration = 0;
+        f32 zx = 0.0f;
+        f32 zy = 0.0f;
+        f32 saved_x = 0.0f;
+        f32 saved_y = 0.0f;
+        f32 dz_x = 1.0f;
+        f32 dz_y = 0.0f;
+        for (; iteration < max_iterations; ++iteration) {
+            f32 x = zx * zx - zy * zy;
+            f32 y = 2.0f * zx * zy;
+            if (x * x + y * y > 4.0f) {
+                break;
+            }
+            zx = x + cx[i];
+            zy = y + cy[i];
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                f32 dx = 2.0f * (zx * dz_x - zy * dz_y);
+                f32 dy = 2.0f * (zx * dz_y + zy * dz_x);
+                dz_x = dx;
+                dz_y = dy;
+                if (dz_x * dz_x + dz_y * dz_y < (f32) KERNEL_ATTRACTION_EPSILON) {
+                    iteration = max_iterations;
+                    stats->attracted++;
+                    break;
+                }
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                if (fabsf(zx - saved_x) < KERNEL_PERIODICITY_EPSILON_F32 &&
+                    fabsf(zy - saved_y) < KERNEL_PERIODICITY_EPSILON_F32) {
+                    iteration = max_iterations;
+                    stats->periodic++;
+                    break;
+                }
+                if ((iteration & (iteration + 1)) == 0) {
+                    saved_x = zx;
+                    saved_y = zy;
+                }
+            }
+        }
+        iterations[i] = iteration;
+    }
+}
+
+static void kernel_scalar_f64(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 checks,
+                              u32 *iterations, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i++) {
+        if (kernel_interior(cx[i], cy[i], 0.0)) {
+            iterations[i] = max_iterations;
+            stats->rejected++;
+            continue;
+        }
+        u32 iteration = 0;
+        f64 zx = 0.0;
+        f64 zy = 0.0;
+        f64 saved_x = 0.0;
+        f64 saved_y = 0.0;
+        f64 dz_x = 1.0;
+        f64 dz_y = 0.0;
+        for (; iteration < max_iterations; ++iteration) {
+            f64 x = zx * zx - zy * zy;
+            f64 y = 2.0 * zx * zy;
+            if (x * x + y * y > 4.0) {
+                break;
+            }
+            zx = x + cx[i];
+            zy = y + cy[i];
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                f64 dx = 2.0 * (zx * dz_x - zy * dz_y);
+                f64 dy = 2.0 * (zx * dz_y + zy * dz_x);
+                dz_x = dx;
+                dz_y = dy;
+                if (dz_x * dz_x + dz_y * dz_y < KERNEL_ATTRACTION_EPSILON) {
+                    iteration = max_iterations;
+                    stats->attracted++;
+                    break;
+                }
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                if (fabs(zx - saved_x) < KERNEL_PERIODICITY_EPSILON_F64 &&
+                    fabs(zy - saved_y) < KERNEL_PERIODICITY_EPSILON_F64) {
+                    iteration = max_iterations;
+                    stats->periodic++;
+                    break;
+                }
+                if ((iteration & (iteration + 1)) == 0) {
+                    saved_x = zx;
+                    saved_y = zy;
+                }
+            }
+        }
+        iterations[i] = iteration;
+    }
+}
+
+// Dekker's splitter for the 53 bit mantissa, 2^27 + 1
+#define KERNEL_SPLITTER 134217729.0
+
+static void kernel_scalar_two_product(f64 a, f64 b, f64 *product, f64 *error) {
+    f64 t = KERNEL_SPLITTER * a;
+    f64 a_hi = t - (t - a);
+    f64 a_lo = a - a_hi;
+    t = KERNEL_SPLITTER * b;
+    f64 b_hi = t - (t - b);
+    f64 b_lo = b - b_hi;
+    *product = a * b;
+    *error = ((a_hi * b_hi - *product) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+}
+
+static void kernel_scalar_two_sum(f64 a, f64 b, f64 *sum, f64 *error) {
+    *sum = a + b;
+    f64 v = *sum - a;
+    *error = (a - (*sum - v)) + (b - v);
+}
+
+static ddouble_t kernel_scalar_add(ddouble_t a, ddouble_t b) {
+    f64 s, e, t, f;
+    kernel_scalar_two_sum(a.hi, b.hi, &s, &e);
+    kernel_scalar_two_sum(a.lo, b.lo, &t, &f);
+    e += t;
+    f64 hi = s + e;
+    e = e - (hi - s);
+    e += f;
+    ddouble_t result;
+    result.hi = hi + e;
+    result.lo = e - (result.hi - hi);
+    return result;
+}
+
+static ddouble_t kernel_scalar_mul(ddouble_t a, ddouble_t b) {
+    f64 p, e;
+    kernel_scalar_two_product(a.hi, b.hi, &p, &e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    ddouble_t result;
+    result.hi = p + e;
+    result.lo = e - (result.hi - p);
+    return result;
+}
+
+static void kernel_scalar_ddouble(const ddouble_t *cx, const ddouble_t *cy, u32 count, u32 max_iterations,
+                                  u32 checks, u32 *iterations, kernel_stats_t *stats) {
+    // The double-double helpers are kept local to this file so they inline into the loop,
+    // the SIMD kernels replicate these exact steps and produce the same counts
+    for (u32 i = 0; i < count; i++) {
+        if (kernel_interior(cx[i].hi, cy[i].hi, KERNEL_INTERIOR_MARGIN)) {
+            iterations[i] = max_iterations;
+            stats->rejected++;
+            continue;
+        }
+        u32 iteration = 0;
+        ddouble_t zx = {0.0, 0.0};
+        ddouble_t zy = {0.0, 0.0};
+        ddouble_t saved_x = {0.0, 0.0};
+        ddouble_t saved_y = {0.0, 0.0};
+        f64 dz_x = 1.0;
+        f64 dz_y = 0.0;
+        for (; iteration < max_iterations; ++iteration) {
+            ddouble_t xx = kernel_scalar_mul(zx, zx);
+            ddouble_t yy = kernel_scalar_mul(zy, zy);
+            ddouble_t xy = kernel_scalar_mul(zx, zy);
+            yy.hi = -yy.hi;
+            yy.lo = -yy.lo;
+            ddouble_t x = kernel_scalar_add(xx, yy);
+            ddouble_t y = {2.0 * xy.hi, 2.0 * xy.lo};
+
+            // The bailout only needs the leading parts
+            if (x.hi * x.hi + y.hi * y.hi > 4.0) {
+                break;
+            }
+            zx = kernel_scalar_add(x, cx[i]);
+            zy = kernel_scalar_add(y, cy[i]);
+            // The derivative only needs the leading parts as well
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                f64 dx = 2.0 * (zx.hi * dz_x - zy.hi * dz_y);
+                f64 dy = 2.0 * (zx.hi * dz_y + zy.hi * dz_x);
+                dz_x = dx;
+                dz_y = dy;
+                if (dz_x * dz_x + dz_y * dz_y < KERNEL_ATTRACTION_EPSILON) {
+                    iteration = max_iterations;
+                    stats->attracted++;
+                    break;
+                }
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                // The distance only needs double precision, the parts are subtracted separately
+                f64 distance_x = (zx.hi - saved_x.hi) + (zx.lo - saved_x.lo);
+                f64 distance_y = (zy.hi - saved_y.hi) + (zy.lo - saved_y.lo);
+                if (fabs(distance_x) < KERNEL_PERIODICITY_EPSILON_DDOUBLE &&
+                    fabs(distance_y) < KERNEL_PERIODICITY_EPSILON_DDOUBLE) {
+                    iteration = max_iterations;
+                    stats->periodic++;
+                    break;
+                }
+                if ((iteration & (iteration + 1)) == 0) {
+                    saved_x = zx;
+                    saved_y = zy;
+                }
+            }
+        }
+        iterations[i] = iteration;
+    }
+}
+
+f64 kernel_distance(f64 zx, f64 zy, f64 dzx, f64 dzy) {
+    f64 magnitude = sqrt(zx * zx + zy * zy);
+    return magnitude * log(magnitude) / sqrt(dzx * dzx + dzy * dzy);
+}
+
+static void kernel_scalar_distance(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 *iterations,
+                                   f64 *distances, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i++) {
+        if (kernel_interior(cx[i], cy[i], 0.0)) {
+            iterations[i] = max_iterations;
+            distances[i] = 0.0;
+            stats->rejected++;
+            continue;
+        }
+        u32 iteration = 0;
+        f64 zx = 0.0;
+        f64 zy = 0.0;
+        f64 dzx = 0.0;
+        f64 dzy = 0.0;
+        for (; iteration < max_iterations; ++iteration) {
+            f64 xx = zx * zx;
+            f64 yy = zy * zy;
+            if (xx + yy > KERNEL_DISTANCE_BAILOUT) {
+                break;
+            }
+            f64 dx = 2.0 * (zx * dzx - zy * dzy) + 1.0;
+            f64 dy = 2.0 * (zx * dzy + zy * dzx);
+            zy = 2.0 * zx * zy + cy[i];
+            zx = xx - yy + cx[i];
+            dzx = dx;
+            dzy = dy;
+        }
+        iterations[i] = iteration;
+        distances[i] = iteration < max_iterations ? kernel_distance(zx, zy, dzx, dzy) : 0.0;
+    }
+}
+
+const kernel_t kernel_scalar = {"scalar", kernel_scalar_f32, kernel_scalar_f64, kernel_scalar_ddouble,
+                                kernel_scalar_distance};
+
+// ===================================================================================
+// KERNEL REGISTRY
+// ===================================================================================
+
+static const kernel_t *kernel_table[KERNEL_COUNT] = {
+        [KERNEL_SCALAR] = &kernel_scalar,
+#ifdef LIBFRACTAL_KERNEL_SSE2
+        [KERNEL_SSE2] = &kernel_sse2,
+#endif
+#ifdef LIBFRACTAL_KERNEL_AVX2
+        [KERNEL_AVX2] = &kernel_avx2,
+#endif
+#ifdef LIBFRACTAL_KERNEL_AVX512
+        [KERNEL_AVX512] = &kernel_avx512,
+#endif
+};
+
+// Render workers read the selection concurrently, kernel_override may change it at any time
+static const kernel_t *_Atomic kernel_selected = NULL;
+
+#ifdef KERNEL_X86
+static void kernel_cpuid(u32 leaf, u32 subleaf, u32 registers[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    __cpuidex((int *) registers, (int) leaf, (int) subleaf);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static u64 kernel_xgetbv(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    u32 low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((u64) high << 32) | low;
+#endif
+}
+#endif
+
+static bool kernel_cpu_supports(kernel_type_t type) {
+    if (type == KERNEL_SCALAR) {
+        return true;
+    }
+#ifdef KERNEL_X86
+    u32 registers[4];
+    kernel_cpuid(0, 0, registers);
+    u32 max_leaf = registers[0];
+
+    kernel_cpuid(1, 0, registers);
+    bool sse2 = (registers[3] >> 26) & 1;
+    bool fma = (registers[2] >> 12) & 1;
+    if (type == KERNEL_SSE2) {
+        return sse2;
+    }
+
+    // The wide registers are only usable if the os saves them on context switches
+    bool osxsave = (registers[2] >> 27) & 1;
+    if (!osxsave || max_leaf < 7) {
+        return false;
+    }
+    u64 xcr0 = kernel_xgetbv();
+    bool ymm_state = (xcr0 & 0x06) == 0x06;
+    bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+    kernel_cpuid(7, 0, registers);
+    bool avx2 = (registers[1] >> 5) & 1;
+    bool avx512f = (registers[1] >> 16) & 1;
+    switch (type) {
+        case KERNEL_AVX2:
+            return avx2 && fma && ymm_state;
+        case KERNEL_AVX512:
+            return avx512f && zmm_state;
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
+
+bool kernel_supported(kernel_type_t type) {
+    return type < KERNEL_COUNT && kernel_table[type] && kernel_cpu_supports(type);
+}
+
+const kernel_t *kernel_get(kernel_type_t type) {
+    return kernel_supported(type) ? kernel_table[type] : NULL;
+}
+
+bool kernel_find(const char *name, kernel_type_t *result) {
+    for (u32 type = 0; type < KERNEL_COUNT; type++) {
+        if (kernel_table[type] && strcmp(kernel_table[type]->name, name) == 0) {
+            *result = (kernel_type_t) type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const kernel_t *kernel_best(void) {
+    for (s32 type = KERNEL_COUNT - 1; type > KERNEL_SCALAR; type--) {
+        if (kernel_supported((kernel_type_t) type)) {
+            return kernel_table[type];
+        }
+    }
+    return &kernel_scalar;
+}
+
+static const kernel_t *kernel_choose(void) {
+    const kernel_t *chosen = kernel_best();
+    const char *forced = getenv(KERNEL_ENVIRONMENT);
+    if (forced && *forced) {
+        kernel_type_t type;
+        if (!kernel_find(forced, &type)) {
+            fprintf(stderr, "[kernel] unknown kernel %s, using %s\n", forced, chosen->name);
+        } else if (!kernel_supported(type)) {
+            fprintf(stderr, "[kernel] kernel %s is not supported, using %s\n", forced, chosen->name);
+        } else {
+            chosen = kernel_table[type];
+        }
+    }
+    return chosen;
+}
+
+const kernel_t *kernel_select(void) {
+    // Threads that race on the first call agree on whichever choice was stored first
+    const kernel_t *selected = atomic_load(&kernel_selected);
+    if (selected) {
+        return selected;
+    }
+    const kernel_t *chosen = kernel_choose();
+    return atomic_compare_exchange_strong(&kernel_selected, &selected, chosen) ? chosen : selected;
+}
+
+bool kernel_override(kernel_type_t type) {
+    if (type == KERNEL_COUNT) {
+        atomic_store(&kernel_selected, NULL);
+        return true;
+    }
+    if (!kernel_supported(type)) {
+        return false;
+    }
+    atomic_store(&kernel_selected, kernel_table[type]);
+    return true;
+}
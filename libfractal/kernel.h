@@ -0,0 +1,231 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_KERNEL_H
+#define LIBFRACTAL_KERNEL_H
+
+#include "types.h"
+
+/**
+ * Counters the kernels add to, a renderer sums them up over a frame. Renderers that
+ * infer pixels from their neighbours count those in filled, they never reach a kernel.
+ */
+typedef struct kernel_stats {
+    u32 rejected;
+    u32 periodic;
+    u32 attracted;
+    u32 filled;
+} kernel_stats_t;
+
+/**
+ * An iteration kernel computes the escape time of count points, c is passed as
+ * separate arrays for the real and imaginary part so that kernels can load them
+ * straight into vector registers. All kernels must produce exactly the iteration
+ * counts of the scalar reference for the same inputs.
+ *
+ * Points inside the main cardioid or the period-2 bulb never escape, kernels assign
+ * them max_iterations right away and count them in stats->rejected. The checks select
+ * further interior tests, see KERNEL_CHECK_PERIODICITY and KERNEL_CHECK_ATTRACTION.
+ */
+typedef void (*kernel_f32_t)(const f32 *cx, const f32 *cy, u32 count, u32 max_iterations, u32 checks,
+                             u32 *iterations, kernel_stats_t *stats);
+typedef void (*kernel_f64_t)(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 checks,
+                             u32 *iterations, kernel_stats_t *stats);
+typedef void (*kernel_ddouble_t)(const ddouble_t *cx, const ddouble_t *cy, u32 count, u32 max_iterations,
+                                 u32 checks, u32 *iterations, kernel_stats_t *stats);
+
+/**
+ * With periodicity checking, z is saved whenever iteration + 1 is a power of two and
+ * compared against every following value (Brent's cycle detection), orbits that come
+ * back to the saved value are interior and counted in stats->periodic.
+ */
+#define KERNEL_CHECK_PERIODICITY (1u << 0)
+
+/**
+ * With the attraction test, the kernels track the derivative of the orbit with respect
+ * to its first value c, dz' = 2 z dz from dz = 1. Orbits drawn into an attracting cycle
+ * shrink it towards zero, once |dz|^2 drops below KERNEL_ATTRACTION_EPSILON the
+ * point is interior and counted in stats->attracted. Only a complex multiply per
+ * iteration and no saved state, cheaper than periodicity checking on SIMD.
+ */
+#define KERNEL_CHECK_ATTRACTION (1u << 1)
+
+/**
+ * Distance estimation kernel, iterates the derivative dz' = 2 z dz + 1 alongside z and
+ * writes the exterior distance estimate |z| ln|z| / |dz| to distances, 0 for points that
+ * do not escape. The bailout radius is raised to KERNEL_DISTANCE_BAILOUT for an accurate
+ * estimate, so the counts differ from the escape-time kernels.
+ */
+typedef void (*kernel_distance_t)(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 *iterations,
+                                  f64 *distances, kernel_stats_t *stats);
+
+/**
+ * Squared bailout radius of the distance estimation kernels
+ */
+#define KERNEL_DISTANCE_BAILOUT 65536.0
+
+/**
+ * The double-double kernels test membership on the leading parts only, points this
+ * close to the boundary are iterated
+ */
+#define KERNEL_INTERIOR_MARGIN 1e-12
+
+/**
+ * Distance per component below which an orbit counts as having returned to the saved
+ * value, a few units in the last place of the orbit values for each precision
+ */
+#define KERNEL_PERIODICITY_EPSILON_F32 0x1p-20f
+#define KERNEL_PERIODICITY_EPSILON_F64 0x1p-40
+#define KERNEL_PERIODICITY_EPSILON_DDOUBLE 0x1p-80
+
+/**
+ * Squared derivative magnitude below which an orbit counts as attracted, the same for
+ * all precisions since the derivative is tracked in f32 or f64 only
+ */
+#define KERNEL_ATTRACTION_EPSILON 0x1p-40
+
+/**
+ * Tests whether the point lies inside the main cardioid or the period-2 bulb, the
+ * SIMD kernels evaluate the same expression lane by lane
+ *
+ * @param cx real part of the point
+ * @param cy imaginary part of the point
+ * @param margin distance to keep from the boundary, in units of the test expressions
+ * @return bool
+ */
+bool kernel_interior(f64 cx, f64 cy, f64 margin);
+
+/**
+ * Computes the distance estimate of an escaped orbit, the SIMD distance kernels
+ * call this once per lane after the loop
+ *
+ * @param zx real part of z after escaping
+ * @param zy imaginary part of z after escaping
+ * @param dzx real part of the derivative
+ * @param dzy imaginary part of the derivative
+ * @return distance estimate
+ */
+f64 kernel_distance(f64 zx, f64 zy, f64 dzx, f64 dzy);
+
+/**
+ * A set of kernels for one instruction set, ddouble and distance may be NULL in
+ * which case the scalar kernel is used
+ */
+typedef struct kernel {
+    const char *name;
+    kernel_f32_t f32;
+    kernel_f64_t f64;
+    kernel_ddouble_t ddouble;
+    kernel_distance_t distance;
+} kernel_t;
+
+/**
+ * Portable scalar kernel, a straight port of the shader loop
+ */
+extern const kernel_t kernel_scalar;
+
+#ifdef LIBFRACTAL_KERNEL_SSE2
+/**
+ * SSE2 kernel, iterates 4 single or 2 double precision points at once
+ */
+extern const kernel_t kernel_sse2;
+#endif
+
+#ifdef LIBFRACTAL_KERNEL_AVX2
+/**
+ * AVX2 kernel, iterates 8 single or 4 double precision points at once,
+ * the double-double kernel requires FMA as well
+ */
+extern const kernel_t kernel_avx2;
+#endif
+
+#ifdef LIBFRACTAL_KERNEL_AVX512
+/**
+ * AVX-512 kernel, iterates 16 single or 8 double precision points at once
+ * and retires escaped lanes through mask registers
+ */
+extern const kernel_t kernel_avx512;
+#endif
+
+// ===================================================================================
+// KERNEL REGISTRY
+// ===================================================================================
+
+typedef enum kernel_type {
+    KERNEL_SCALAR = 0, KERNEL_SSE2, KERNEL_AVX2, KERNEL_AVX512, KERNEL_COUNT
+} kernel_type_t;
+
+/**
+ * Version of the iterations the kernels compute, bumped whenever a change alters the result
+ * for any point. Iterations persisted by another version are discarded, see store_open
+ */
+#define KERNEL_VERSION 1
+
+/**
+ * Environment variable that forces a specific kernel by name, e.g. FRACTAL_KERNEL=sse2
+ */
+#define KERNEL_ENVIRONMENT "FRACTAL_KERNEL"
+
+/**
+ * Checks whether the kernel was compiled in and can run on this cpu
+ *
+ * @param type kernel type
+ * @return bool
+ */
+bool kernel_supported(kernel_type_t type);
+
+/**
+ * Returns the specified kernel
+ *
+ * @param type kernel type
+ * @return kernel handle, NULL if the kernel is not supported
+ */
+const kernel_t *kernel_get(kernel_type_t type);
+
+/**
+ * Looks up a kernel by its name
+ *
+ * @param name kernel name
+ * @param result pointer to the resulting kernel type
+ * @return bool
+ */
+bool kernel_find(const char *name, kernel_type_t *result);
+
+/**
+ * Returns the kernel used for rendering. The first call probes the cpu and picks the
+ * best supported kernel, unless the environment or kernel_override says otherwise.
+ *
+ * @return kernel handle
+ */
+const kernel_t *kernel_select(void);
+
+/**
+ * Forces the specified kernel for all subsequent renders, used for benchmarking
+ *
+ * @param type kernel type, KERNEL_COUNT restores the automatic selection
+ * @return false if the kernel is not supported, the selection is left untouched then
+ */
+bool kernel_override(kernel_type_t type);
+
+#endif// LIBFRACTAL_KERNEL_H
@@ -0,0 +1,525 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "kernel.h"
+#include "math.h"
+
+// This translation unit is compiled with -mavx2 -mfma, the kernel is only
+// ever called after the cpu has been checked for support
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+// ===================================================================================
+// AVX2 KERNEL
+// ===================================================================================
+
+// Each call iterates two independent vectors, the recurrence is latency bound
+// and interleaving them keeps the execution units busy
+#define KERNEL_AVX2_F32_LANES 16
+#define KERNEL_AVX2_F64_LANES 8
+
+static __m256 kernel_avx2_f32_interior(__m256 c_x, __m256 c_y) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 quarter = _mm256_set1_ps(0.25f);
+    __m256 xq = _mm256_sub_ps(c_x, quarter);
+    __m256 yy = _mm256_mul_ps(c_y, c_y);
+    __m256 q = _mm256_add_ps(_mm256_mul_ps(xq, xq), yy);
+    __m256 x1 = _mm256_add_ps(c_x, one);
+    __m256 bulb = _mm256_add_ps(_mm256_mul_ps(x1, x1), yy);
+    __m256 cardioid = _mm256_cmp_ps(_mm256_mul_ps(q, _mm256_add_ps(q, xq)), _mm256_mul_ps(quarter, yy), _CMP_LT_OQ);
+    return _mm256_or_ps(cardioid, _mm256_cmp_ps(bulb, _mm256_set1_ps(0.0625f), _CMP_LT_OQ));
+}
+
+static __m256d kernel_avx2_f64_interior(__m256d c_x, __m256d c_y, f64 margin) {
+    // Same expression as kernel_interior, the margin is only used by the double-double kernel
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d quarter = _mm256_set1_pd(0.25);
+    __m256d offset = _mm256_set1_pd(margin);
+    __m256d xq = _mm256_sub_pd(c_x, quarter);
+    __m256d yy = _mm256_mul_pd(c_y, c_y);
+    __m256d q = _mm256_add_pd(_mm256_mul_pd(xq, xq), yy);
+    __m256d x1 = _mm256_add_pd(c_x, one);
+    __m256d bulb = _mm256_add_pd(_mm256_mul_pd(x1, x1), yy);
+    __m256d cardioid = _mm256_cmp_pd(_mm256_mul_pd(q, _mm256_add_pd(q, xq)),
+                                     _mm256_sub_pd(_mm256_mul_pd(quarter, yy), offset), _CMP_LT_OQ);
+    bulb = _mm256_cmp_pd(bulb, _mm256_sub_pd(_mm256_set1_pd(0.0625), offset), _CMP_LT_OQ);
+    return _mm256_or_pd(cardioid, bulb);
+}
+
+static void kernel_avx2_f32_lanes(const f32 *cx, const f32 *cy, u32 lanes, u32 max_iterations, u32 checks,
+                                  u32 *iterations, kernel_stats_t *stats) {
+    __m256 c_x[2] = {_mm256_loadu_ps(cx), _mm256_loadu_ps(cx + 8)};
+    __m256 c_y[2] = {_mm256_loadu_ps(cy), _mm256_loadu_ps(cy + 8)};
+    __m256 z_x[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m256 z_y[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m256 saved_x[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m256 saved_y[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m256 dz_x[2] = {_mm256_set1_ps(1.0f), _mm256_set1_ps(1.0f)};
+    __m256 dz_y[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m256 two = _mm256_set1_ps(2.0f);
+    __m256 four = _mm256_set1_ps(4.0f);
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 epsilon = _mm256_set1_ps(KERNEL_PERIODICITY_EPSILON_F32);
+    __m256 attraction = _mm256_set1_ps((f32) KERNEL_ATTRACTION_EPSILON);
+    __m256i limit = _mm256_set1_epi32((s32) max_iterations);
+
+    // Lanes stay active until they escape, every active lane adds one per
+    // iteration, the mask doubles as -1 in each active lane. Escaped lanes keep
+    // iterating towards inf/nan, which is cheaper than blending them out and
+    // harmless because the mask never turns a lane back on. Lanes inside the
+    // cardioid or bulb start out finished at max_iterations
+    __m256 active[2];
+    __m256i count[2];
+    u32 interior = 0;
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 v = 0; v < 2; v++) {
+        __m256 inside = kernel_avx2_f32_interior(c_x[v], c_y[v]);
+        active[v] = _mm256_andnot_ps(inside, _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+        count[v] = _mm256_and_si256(_mm256_castps_si256(inside), limit);
+        interior |= (u32) _mm256_movemask_ps(inside) << (8 * v);
+    }
+
+    // Nothing left to iterate once every lane was rejected
+    for (u32 iteration = interior == 0xffff ? max_iterations : 0; iteration < max_iterations; ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            // No fused multiply-add here, the rounding has to match the shader
+            __m256 x = _mm256_sub_ps(_mm256_mul_ps(z_x[v], z_x[v]), _mm256_mul_ps(z_y[v], z_y[v]));
+            __m256 y = _mm256_mul_ps(_mm256_mul_ps(two, z_x[v]), z_y[v]);
+            __m256 magnitude = _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y));
+            active[v] = _mm256_andnot_ps(_mm256_cmp_ps(magnitude, four, _CMP_GT_OQ), active[v]);
+            count[v] = _mm256_sub_epi32(count[v], _mm256_castps_si256(active[v]));
+            z_x[v] = _mm256_add_ps(x, c_x[v]);
+            z_y[v] = _mm256_add_ps(y, c_y[v]);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                // Lanes whose derivative collapsed are drawn into a cycle and finish at max_iterations
+                __m256 dx = _mm256_sub_ps(_mm256_mul_ps(z_x[v], dz_x[v]), _mm256_mul_ps(z_y[v], dz_y[v]));
+                __m256 dy = _mm256_add_ps(_mm256_mul_ps(z_x[v], dz_y[v]), _mm256_mul_ps(z_y[v], dz_x[v]));
+                dz_x[v] = _mm256_mul_ps(two, dx);
+                dz_y[v] = _mm256_mul_ps(two, dy);
+                __m256 derivative = _mm256_add_ps(_mm256_mul_ps(dz_x[v], dz_x[v]), _mm256_mul_ps(dz_y[v], dz_y[v]));
+                __m256 attracted_lanes = _mm256_and_ps(_mm256_cmp_ps(derivative, attraction, _CMP_LT_OQ), active[v]);
+                count[v] = _mm256_blendv_epi8(count[v], limit, _mm256_castps_si256(attracted_lanes));
+                active[v] = _mm256_andnot_ps(attracted_lanes, active[v]);
+                attracted |= (u32) _mm256_movemask_ps(attracted_lanes) << (8 * v);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                // Lanes that came back to the saved value finish at max_iterations
+                __m256 distance_x = _mm256_andnot_ps(sign, _mm256_sub_ps(z_x[v], saved_x[v]));
+                __m256 distance_y = _mm256_andnot_ps(sign, _mm256_sub_ps(z_y[v], saved_y[v]));
+                __m256 cycle = _mm256_and_ps(_mm256_cmp_ps(distance_x, epsilon, _CMP_LT_OQ),
+                                             _mm256_cmp_ps(distance_y, epsilon, _CMP_LT_OQ));
+                cycle = _mm256_and_ps(cycle, active[v]);
+                count[v] = _mm256_blendv_epi8(count[v], limit, _mm256_castps_si256(cycle));
+                active[v] = _mm256_andnot_ps(cycle, active[v]);
+                periodic |= (u32) _mm256_movemask_ps(cycle) << (8 * v);
+            }
+        }
+        if ((checks & KERNEL_CHECK_PERIODICITY) && (iteration & (iteration + 1)) == 0) {
+            for (u32 v = 0; v < 2; v++) {
+                saved_x[v] = z_x[v];
+                saved_y[v] = z_y[v];
+            }
+        }
+        if (_mm256_movemask_ps(_mm256_or_ps(active[0], active[1])) == 0) {
+            break;
+        }
+    }
+    _mm256_storeu_si256((__m256i *) iterations, count[0]);
+    _mm256_storeu_si256((__m256i *) (iterations + 8), count[1]);
+
+    // Padding lanes of the tail are not counted
+    u32 valid = (1u << lanes) - 1;
+    stats->rejected += u32_popcount(interior & valid);
+    stats->periodic += u32_popcount(periodic & valid);
+    stats->attracted += u32_popcount(attracted & valid);
+}
+
+static void kernel_avx2_f64_lanes(const f64 *cx, const f64 *cy, u32 lanes, u32 max_iterations, u32 checks,
+                                  u32 *iterations, kernel_stats_t *stats) {
+    __m256d c_x[2] = {_mm256_loadu_pd(cx), _mm256_loadu_pd(cx + 4)};
+    __m256d c_y[2] = {_mm256_loadu_pd(cy), _mm256_loadu_pd(cy + 4)};
+    __m256d z_x[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d z_y[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d saved_x[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d saved_y[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d dz_x[2] = {_mm256_set1_pd(1.0), _mm256_set1_pd(1.0)};
+    __m256d dz_y[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d two = _mm256_set1_pd(2.0);
+    __m256d four = _mm256_set1_pd(4.0);
+    __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d epsilon = _mm256_set1_pd(KERNEL_PERIODICITY_EPSILON_F64);
+    __m256d attraction = _mm256_set1_pd(KERNEL_ATTRACTION_EPSILON);
+    __m256i limit = _mm256_set1_epi64x(max_iterations);
+
+    __m256d active[2];
+    __m256i count[2];
+    u32 interior = 0;
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 v = 0; v < 2; v++) {
+        __m256d inside = kernel_avx2_f64_interior(c_x[v], c_y[v], 0.0);
+        active[v] = _mm256_andnot_pd(inside, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+        count[v] = _mm256_and_si256(_mm256_castpd_si256(inside), limit);
+        interior |= (u32) _mm256_movemask_pd(inside) << (4 * v);
+    }
+
+    for (u32 iteration = interior == 0xff ? max_iterations : 0; iteration < max_iterations; ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            __m256d x = _mm256_sub_pd(_mm256_mul_pd(z_x[v], z_x[v]), _mm256_mul_pd(z_y[v], z_y[v]));
+            __m256d y = _mm256_mul_pd(_mm256_mul_pd(two, z_x[v]), z_y[v]);
+            __m256d magnitude = _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+            active[v] = _mm256_andnot_pd(_mm256_cmp_pd(magnitude, four, _CMP_GT_OQ), active[v]);
+            count[v] = _mm256_sub_epi64(count[v], _mm256_castpd_si256(active[v]));
+            z_x[v] = _mm256_add_pd(x, c_x[v]);
+            z_y[v] = _mm256_add_pd(y, c_y[v]);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                __m256d dx = _mm256_sub_pd(_mm256_mul_pd(z_x[v], dz_x[v]), _mm256_mul_pd(z_y[v], dz_y[v]));
+                __m256d dy = _mm256_add_pd(_mm256_mul_pd(z_x[v], dz_y[v]), _mm256_mul_pd(z_y[v], dz_x[v]));
+                dz_x[v] = _mm256_mul_pd(two, dx);
+                dz_y[v] = _mm256_mul_pd(two, dy);
+                __m256d derivative = _mm256_add_pd(_mm256_mul_pd(dz_x[v], dz_x[v]), _mm256_mul_pd(dz_y[v], dz_y[v]));
+                __m256d attracted_lanes = _mm256_and_pd(_mm256_cmp_pd(derivative, attraction, _CMP_LT_OQ), active[v]);
+                count[v] = _mm256_blendv_epi8(count[v], limit, _mm256_castpd_si256(attracted_lanes));
+                active[v] = _mm256_andnot_pd(attracted_lanes, active[v]);
+                attracted |= (u32) _mm256_movemask_pd(attracted_lanes) << (4 * v);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                __m256d distance_x = _mm256_andnot_pd(sign, _mm256_sub_pd(z_x[v], saved_x[v]));
+                __m256d distance_y = _mm256_andnot_pd(sign, _mm256_sub_pd(z_y[v], saved_y[v]));
+                __m256d cycle = _mm256_and_pd(_mm256_cmp_pd(distance_x, epsilon, _CMP_LT_OQ),
+                                              _mm256_cmp_pd(distance_y, epsilon, _CMP_LT_OQ));
+                cycle = _mm256_and_pd(cycle, active[v]);
+                count[v] = _mm256_blendv_epi8(count[v], limit, _mm256_castpd_si256(cycle));
+                active[v] = _mm256_andnot_pd(cycle, active[v]);
+                periodic |= (u32) _mm256_movemask_pd(cycle) << (4 * v);
+            }
+        }
+        if ((checks & KERNEL_CHECK_PERIODICITY) && (iteration & (iteration + 1)) == 0) {
+            for (u32 v = 0; v < 2; v++) {
+                saved_x[v] = z_x[v];
+                saved_y[v] = z_y[v];
+            }
+        }
+        if (_mm256_movemask_pd(_mm256_or_pd(active[0], active[1])) == 0) {
+            break;
+        }
+    }
+
+    u64 result[KERNEL_AVX2_F64_LANES];
+    _mm256_storeu_si256((__m256i *) result, count[0]);
+    _mm256_storeu_si256((__m256i *) (result + 4), count[1]);
+    for (u32 i = 0; i < KERNEL_AVX2_F64_LANES; i++) {
+        iterations[i] = (u32) result[i];
+    }
+
+    u32 valid = (1u << lanes) - 1;
+    stats->rejected += u32_popcount(interior & valid);
+    stats->periodic += u32_popcount(periodic & valid);
+    stats->attracted += u32_popcount(attracted & valid);
+}
+
+static void kernel_avx2_f32(const f32 *cx, const f32 *cy, u32 count, u32 max_iterations, u32 checks,
+                            u32 *iterations, kernel_stats_t *stats) {
+    u32 i = 0;
+    for (; i + KERNEL_AVX2_F32_LANES <= count; i += KERNEL_AVX2_F32_LANES) {
+        kernel_avx2_f32_lanes(cx + i, cy + i, KERNEL_AVX2_F32_LANES, max_iterations, checks, iterations + i,
+                              stats);
+    }
+
+    // The tail is padded by repeating the last point, only the valid lanes are written back
+    if (i < count) {
+        f32 tail_x[KERNEL_AVX2_F32_LANES];
+        f32 tail_y[KERNEL_AVX2_F32_LANES];
+        u32 tail_iterations[KERNEL_AVX2_F32_LANES];
+        for (u32 lane = 0; lane < KERNEL_AVX2_F32_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            tail_x[lane] = cx[index];
+            tail_y[lane] = cy[index];
+        }
+        kernel_avx2_f32_lanes(tail_x, tail_y, count - i, max_iterations, checks, tail_iterations, stats);
+        for (u32 lane = 0; i + lane < count; lane++) {
+            iterations[i + lane] = tail_iterations[lane];
+        }
+    }
+}
+
+static void kernel_avx2_f64(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 checks,
+                            u32 *iterations, kernel_stats_t *stats) {
+    u32 i = 0;
+    for (; i + KERNEL_AVX2_F64_LANES <= count; i += KERNEL_AVX2_F64_LANES) {
+        kernel_avx2_f64_lanes(cx + i, cy + i, KERNEL_AVX2_F64_LANES, max_iterations, checks, iterations + i,
+                              stats);
+    }
+
+    if (i < count) {
+        f64 tail_x[KERNEL_AVX2_F64_LANES];
+        f64 tail_y[KERNEL_AVX2_F64_LANES];
+        u32 tail_iterations[KERNEL_AVX2_F64_LANES];
+        for (u32 lane = 0; lane < KERNEL_AVX2_F64_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            tail_x[lane] = cx[index];
+            tail_y[lane] = cy[index];
+        }
+        kernel_avx2_f64_lanes(tail_x, tail_y, count - i, max_iterations, checks, tail_iterations, stats);
+        for (u32 lane = 0; i + lane < count; lane++) {
+            iterations[i + lane] = tail_iterations[lane];
+        }
+    }
+}
+
+// ===================================================================================
+// AVX2 DOUBLE-DOUBLE KERNEL
+// ===================================================================================
+
+#define KERNEL_AVX2_DDOUBLE_LANES 4
+
+typedef struct kernel_avx2_ddouble {
+    __m256d hi;
+    __m256d lo;
+} kernel_avx2_ddouble_t;
+
+static inline kernel_avx2_ddouble_t kernel_avx2_ddouble_add(kernel_avx2_ddouble_t a, kernel_avx2_ddouble_t b) {
+    // Same steps as the scalar kernel, two-sum of both parts followed by renormalization
+    __m256d s = _mm256_add_pd(a.hi, b.hi);
+    __m256d v = _mm256_sub_pd(s, a.hi);
+    __m256d e = _mm256_add_pd(_mm256_sub_pd(a.hi, _mm256_sub_pd(s, v)), _mm256_sub_pd(b.hi, v));
+    __m256d t = _mm256_add_pd(a.lo, b.lo);
+    __m256d w = _mm256_sub_pd(t, a.lo);
+    __m256d f = _mm256_add_pd(_mm256_sub_pd(a.lo, _mm256_sub_pd(t, w)), _mm256_sub_pd(b.lo, w));
+    e = _mm256_add_pd(e, t);
+    __m256d hi = _mm256_add_pd(s, e);
+    e = _mm256_sub_pd(e, _mm256_sub_pd(hi, s));
+    e = _mm256_add_pd(e, f);
+
+    kernel_avx2_ddouble_t result;
+    result.hi = _mm256_add_pd(hi, e);
+    result.lo = _mm256_sub_pd(e, _mm256_sub_pd(result.hi, hi));
+    return result;
+}
+
+static inline kernel_avx2_ddouble_t kernel_avx2_ddouble_mul(kernel_avx2_ddouble_t a, kernel_avx2_ddouble_t b) {
+    // The fused multiply-subtract yields the exact rounding error of the product,
+    // which is the same value Dekker's splitting computes in the scalar kernel
+    __m256d p = _mm256_mul_pd(a.hi, b.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, b.hi, p);
+    e = _mm256_add_pd(e, _mm256_add_pd(_mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi)));
+
+    kernel_avx2_ddouble_t result;
+    result.hi = _mm256_add_pd(p, e);
+    result.lo = _mm256_sub_pd(e, _mm256_sub_pd(result.hi, p));
+    return result;
+}
+
+static void kernel_avx2_ddouble_lanes(const f64 *cx, const f64 *cy, u32 lanes, u32 max_iterations, u32 checks,
+                                      u32 *iterations, kernel_stats_t *stats) {
+    kernel_avx2_ddouble_t c_x = {_mm256_loadu_pd(cx), _mm256_loadu_pd(cx + KERNEL_AVX2_DDOUBLE_LANES)};
+    kernel_avx2_ddouble_t c_y = {_mm256_loadu_pd(cy), _mm256_loadu_pd(cy + KERNEL_AVX2_DDOUBLE_LANES)};
+    kernel_avx2_ddouble_t z_x = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    kernel_avx2_ddouble_t z_y = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    kernel_avx2_ddouble_t saved_x = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    kernel_avx2_ddouble_t saved_y = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d dz_x = _mm256_set1_pd(1.0);
+    __m256d dz_y = _mm256_setzero_pd();
+    __m256d two = _mm256_set1_pd(2.0);
+    __m256d four = _mm256_set1_pd(4.0);
+    __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d epsilon = _mm256_set1_pd(KERNEL_PERIODICITY_EPSILON_DDOUBLE);
+    __m256d attraction = _mm256_set1_pd(KERNEL_ATTRACTION_EPSILON);
+    __m256i limit = _mm256_set1_epi64x(max_iterations);
+
+    // Membership is decided on the high parts, points within the margin are iterated
+    __m256d inside = kernel_avx2_f64_interior(c_x.hi, c_y.hi, KERNEL_INTERIOR_MARGIN);
+    __m256d active = _mm256_andnot_pd(inside, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+    __m256i count = _mm256_and_si256(_mm256_castpd_si256(inside), limit);
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 iteration = 0; iteration < max_iterations; ++iteration) {
+        kernel_avx2_ddouble_t xx = kernel_avx2_ddouble_mul(z_x, z_x);
+        kernel_avx2_ddouble_t yy = kernel_avx2_ddouble_mul(z_y, z_y);
+        kernel_avx2_ddouble_t xy = kernel_avx2_ddouble_mul(z_x, z_y);
+        yy.hi = _mm256_xor_pd(yy.hi, sign);
+        yy.lo = _mm256_xor_pd(yy.lo, sign);
+        kernel_avx2_ddouble_t x = kernel_avx2_ddouble_add(xx, yy);
+        kernel_avx2_ddouble_t y = {_mm256_mul_pd(two, xy.hi), _mm256_mul_pd(two, xy.lo)};
+
+        __m256d magnitude = _mm256_add_pd(_mm256_mul_pd(x.hi, x.hi), _mm256_mul_pd(y.hi, y.hi));
+        active = _mm256_andnot_pd(_mm256_cmp_pd(magnitude, four, _CMP_GT_OQ), active);
+        if (_mm256_movemask_pd(active) == 0) {
+            break;
+        }
+        count = _mm256_sub_epi64(count, _mm256_castpd_si256(active));
+        z_x = kernel_avx2_ddouble_add(x, c_x);
+        z_y = kernel_avx2_ddouble_add(y, c_y);
+        if (checks & KERNEL_CHECK_ATTRACTION) {
+            __m256d dx = _mm256_sub_pd(_mm256_mul_pd(z_x.hi, dz_x), _mm256_mul_pd(z_y.hi, dz_y));
+            __m256d dy = _mm256_add_pd(_mm256_mul_pd(z_x.hi, dz_y), _mm256_mul_pd(z_y.hi, dz_x));
+            dz_x = _mm256_mul_pd(two, dx);
+            dz_y = _mm256_mul_pd(two, dy);
+            __m256d derivative = _mm256_add_pd(_mm256_mul_pd(dz_x, dz_x), _mm256_mul_pd(dz_y, dz_y));
+            __m256d attracted_lanes = _mm256_and_pd(_mm256_cmp_pd(derivative, attraction, _CMP_LT_OQ), active);
+            count = _mm256_blendv_epi8(count, limit, _mm256_castpd_si256(attracted_lanes));
+            active = _mm256_andnot_pd(attracted_lanes, active);
+            attracted |= (u32) _mm256_movemask_pd(attracted_lanes);
+        }
+        if (checks & KERNEL_CHECK_PERIODICITY) {
+            __m256d distance_x = _mm256_add_pd(_mm256_sub_pd(z_x.hi, saved_x.hi), _mm256_sub_pd(z_x.lo, saved_x.lo));
+            __m256d distance_y = _mm256_add_pd(_mm256_sub_pd(z_y.hi, saved_y.hi), _mm256_sub_pd(z_y.lo, saved_y.lo));
+            __m256d cycle = _mm256_and_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, distance_x), epsilon, _CMP_LT_OQ),
+                                          _mm256_cmp_pd(_mm256_andnot_pd(sign, distance_y), epsilon, _CMP_LT_OQ));
+            cycle = _mm256_and_pd(cycle, active);
+            count = _mm256_blendv_epi8(count, limit, _mm256_castpd_si256(cycle));
+            active = _mm256_andnot_pd(cycle, active);
+            periodic |= (u32) _mm256_movemask_pd(cycle);
+            if ((iteration & (iteration + 1)) == 0) {
+                saved_x = z_x;
+                saved_y = z_y;
+            }
+        }
+    }
+
+    u64 result[KERNEL_AVX2_DDOUBLE_LANES];
+    _mm256_storeu_si256((__m256i *) result, count);
+    for (u32 i = 0; i < KERNEL_AVX2_DDOUBLE_LANES; i++) {
+        iterations[i] = (u32) result[i];
+    }
+
+    u32 valid = (1u << lanes) - 1;
+    stats->rejected += u32_popcount((u32) _mm256_movemask_pd(inside) & valid);
+    stats->periodic += u32_popcount(periodic & valid);
+    stats->attracted += u32_popcount(attracted & valid);
+}
+
+static void kernel_avx2_ddouble(const ddouble_t *cx, const ddouble_t *cy, u32 count, u32 max_iterations,
+                                u32 checks, u32 *iterations, kernel_stats_t *stats) {
+    // Points are transposed into separate high and low parts, the tail is padded by
+    // repeating the last point and only the valid lanes are written back
+    for (u32 i = 0; i < count; i += KERNEL_AVX2_DDOUBLE_LANES) {
+        f64 lanes_x[2 * KERNEL_AVX2_DDOUBLE_LANES];
+        f64 lanes_y[2 * KERNEL_AVX2_DDOUBLE_LANES];
+        u32 lanes_iterations[KERNEL_AVX2_DDOUBLE_LANES];
+        for (u32 lane = 0; lane < KERNEL_AVX2_DDOUBLE_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            lanes_x[lane] = cx[index].hi;
+            lanes_x[KERNEL_AVX2_DDOUBLE_LANES + lane] = cx[index].lo;
+            lanes_y[lane] = cy[index].hi;
+            lanes_y[KERNEL_AVX2_DDOUBLE_LANES + lane] = cy[index].lo;
+        }
+        u32 lanes = count - i < KERNEL_AVX2_DDOUBLE_LANES ? count - i : KERNEL_AVX2_DDOUBLE_LANES;
+        kernel_avx2_ddouble_lanes(lanes_x, lanes_y, lanes, max_iterations, checks, lanes_iterations, stats);
+        for (u32 lane = 0; lane < lanes; lane++) {
+            iterations[i + lane] = lanes_iterations[lane];
+        }
+    }
+}
+
+// ===================================================================================
+// AVX2 DISTANCE KERNEL
+// ===================================================================================
+
+static void kernel_avx2_distance_lanes(const f64 *cx, const f64 *cy, u32 lanes, u32 max_iterations, u32 *iterations,
+                                       f64 *distances, kernel_stats_t *stats) {
+    __m256d c_x[2] = {_mm256_loadu_pd(cx), _mm256_loadu_pd(cx + 4)};
+    __m256d c_y[2] = {_mm256_loadu_pd(cy), _mm256_loadu_pd(cy + 4)};
+    __m256d z_x[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d z_y[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d dz_x[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d dz_y[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d two = _mm256_set1_pd(2.0);
+    __m256d bailout = _mm256_set1_pd(KERNEL_DISTANCE_BAILOUT);
+
+    __m256d active[2];
+    __m256i count[2];
+    u32 interior = 0;
+    for (u32 v = 0; v < 2; v++) {
+        __m256d inside = kernel_avx2_f64_interior(c_x[v], c_y[v], 0.0);
+        active[v] = _mm256_andnot_pd(inside, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+        count[v] = _mm256_and_si256(_mm256_castpd_si256(inside), _mm256_set1_epi64x(max_iterations));
+        interior |= (u32) _mm256_movemask_pd(inside) << (4 * v);
+    }
+
+    // Escaped lanes have to keep z and dz for the estimate, only active lanes are updated
+    for (u32 iteration = interior == 0xff ? max_iterations : 0; iteration < max_iterations; ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            __m256d xx = _mm256_mul_pd(z_x[v], z_x[v]);
+            __m256d yy = _mm256_mul_pd(z_y[v], z_y[v]);
+            active[v] = _mm256_andnot_pd(_mm256_cmp_pd(_mm256_add_pd(xx, yy), bailout, _CMP_GT_OQ), active[v]);
+            count[v] = _mm256_sub_epi64(count[v], _mm256_castpd_si256(active[v]));
+            __m256d dx = _mm256_add_pd(
+                    _mm256_mul_pd(two, _mm256_sub_pd(_mm256_mul_pd(z_x[v], dz_x[v]), _mm256_mul_pd(z_y[v], dz_y[v]))),
+                    one);
+            __m256d dy =
+                    _mm256_mul_pd(two, _mm256_add_pd(_mm256_mul_pd(z_x[v], dz_y[v]), _mm256_mul_pd(z_y[v], dz_x[v])));
+            __m256d y = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(two, z_x[v]), z_y[v]), c_y[v]);
+            __m256d x = _mm256_add_pd(_mm256_sub_pd(xx, yy), c_x[v]);
+            z_x[v] = _mm256_blendv_pd(z_x[v], x, active[v]);
+            z_y[v] = _mm256_blendv_pd(z_y[v], y, active[v]);
+            dz_x[v] = _mm256_blendv_pd(dz_x[v], dx, active[v]);
+            dz_y[v] = _mm256_blendv_pd(dz_y[v], dy, active[v]);
+        }
+        if (_mm256_movemask_pd(_mm256_or_pd(active[0], active[1])) == 0) {
+            break;
+        }
+    }
+
+    // The logarithm is only needed once per lane
+    u64 result[KERNEL_AVX2_F64_LANES];
+    f64 lanes_z[4][KERNEL_AVX2_F64_LANES];
+    for (u32 v = 0; v < 2; v++) {
+        _mm256_storeu_si256((__m256i *) (result + 4 * v), count[v]);
+        _mm256_storeu_pd(lanes_z[0] + 4 * v, z_x[v]);
+        _mm256_storeu_pd(lanes_z[1] + 4 * v, z_y[v]);
+        _mm256_storeu_pd(lanes_z[2] + 4 * v, dz_x[v]);
+        _mm256_storeu_pd(lanes_z[3] + 4 * v, dz_y[v]);
+    }
+    for (u32 i = 0; i < lanes; i++) {
+        iterations[i] = (u32) result[i];
+        distances[i] = iterations[i] < max_iterations
+                               ? kernel_distance(lanes_z[0][i], lanes_z[1][i], lanes_z[2][i], lanes_z[3][i])
+                               : 0.0;
+    }
+    stats->rejected += u32_popcount(interior & ((1u << lanes) - 1));
+}
+
+static void kernel_avx2_distance(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 *iterations,
+                                 f64 *distances, kernel_stats_t *stats) {
+    // The tail is padded by repeating the last point, only the valid lanes are written back
+    for (u32 i = 0; i < count; i += KERNEL_AVX2_F64_LANES) {
+        f64 lanes_x[KERNEL_AVX2_F64_LANES];
+        f64 lanes_y[KERNEL_AVX2_F64_LANES];
+        for (u32 lane = 0; lane < KERNEL_AVX2_F64_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            lanes_x[lane] = cx[index];
+            lanes_y[lane] = cy[index];
+        }
+        u32 lanes = count - i < KERNEL_AVX2_F64_LANES ? count - i : KERNEL_AVX2_F64_LANES;
+        kernel_avx2_distance_lanes(lanes_x, lanes_y, lanes, max_iterations, iterations + i, distances + i, stats);
+    }
+}
+
+const kernel_t kernel_avx2 = {"avx2", kernel_avx2_f32, kernel_avx2_f64, kernel_avx2_ddouble, kernel_avx2_distance};
+
+#endif
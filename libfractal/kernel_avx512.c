@@ -0,0 +1,465 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "kernel.h"
+#include "math.h"
+
+// This translation unit is compiled with -mavx512f, the kernel is only
+// ever called after the cpu has been checked for support
+#ifdef __AVX512F__
+
+#include <immintrin.h>
+
+// ===================================================================================
+// AVX-512 KERNEL
+// ===================================================================================
+
+// Each call iterates two independent vectors, see the AVX2 kernel
+#define KERNEL_AVX512_F32_LANES 32
+#define KERNEL_AVX512_F64_LANES 16
+
+static __mmask16 kernel_avx512_mask16(u32 count) {
+    return count >= 16 ? (__mmask16) 0xFFFF : (__mmask16) ((1u << count) - 1u);
+}
+
+static __mmask8 kernel_avx512_mask8(u32 count) {
+    return count >= 8 ? (__mmask8) 0xFF : (__mmask8) ((1u << count) - 1u);
+}
+
+static __mmask16 kernel_avx512_f32_interior(__mmask16 mask, __m512 c_x, __m512 c_y) {
+    __m512 quarter = _mm512_set1_ps(0.25f);
+    __m512 xq = _mm512_sub_ps(c_x, quarter);
+    __m512 yy = _mm512_mul_ps(c_y, c_y);
+    __m512 q = _mm512_add_ps(_mm512_mul_ps(xq, xq), yy);
+    __m512 x1 = _mm512_add_ps(c_x, _mm512_set1_ps(1.0f));
+    __m512 bulb = _mm512_add_ps(_mm512_mul_ps(x1, x1), yy);
+    __mmask16 cardioid = _mm512_mask_cmp_ps_mask(mask, _mm512_mul_ps(q, _mm512_add_ps(q, xq)),
+                                                 _mm512_mul_ps(quarter, yy), _CMP_LT_OQ);
+    return cardioid | _mm512_mask_cmp_ps_mask(mask, bulb, _mm512_set1_ps(0.0625f), _CMP_LT_OQ);
+}
+
+static __mmask8 kernel_avx512_f64_interior(__mmask8 mask, __m512d c_x, __m512d c_y, f64 margin) {
+    // Same expression as kernel_interior, the margin is only used by the double-double kernel
+    __m512d quarter = _mm512_set1_pd(0.25);
+    __m512d offset = _mm512_set1_pd(margin);
+    __m512d xq = _mm512_sub_pd(c_x, quarter);
+    __m512d yy = _mm512_mul_pd(c_y, c_y);
+    __m512d q = _mm512_add_pd(_mm512_mul_pd(xq, xq), yy);
+    __m512d x1 = _mm512_add_pd(c_x, _mm512_set1_pd(1.0));
+    __m512d bulb = _mm512_add_pd(_mm512_mul_pd(x1, x1), yy);
+    __mmask8 cardioid = _mm512_mask_cmp_pd_mask(mask, _mm512_mul_pd(q, _mm512_add_pd(q, xq)),
+                                                _mm512_sub_pd(_mm512_mul_pd(quarter, yy), offset), _CMP_LT_OQ);
+    return cardioid |
+           _mm512_mask_cmp_pd_mask(mask, bulb, _mm512_sub_pd(_mm512_set1_pd(0.0625), offset), _CMP_LT_OQ);
+}
+
+static void kernel_avx512_f32_lanes(const f32 *cx, const f32 *cy, u32 count, u32 max_iterations, u32 checks,
+                                    u32 *iterations, kernel_stats_t *stats) {
+    // Lanes past count are never loaded nor stored, they simply start out inactive
+    __mmask16 active[2] = {kernel_avx512_mask16(count), kernel_avx512_mask16(count > 16 ? count - 16 : 0)};
+    __m512 c_x[2] = {_mm512_maskz_loadu_ps(active[0], cx), _mm512_maskz_loadu_ps(active[1], cx + 16)};
+    __m512 c_y[2] = {_mm512_maskz_loadu_ps(active[0], cy), _mm512_maskz_loadu_ps(active[1], cy + 16)};
+    __m512 z_x[2] = {_mm512_setzero_ps(), _mm512_setzero_ps()};
+    __m512 z_y[2] = {_mm512_setzero_ps(), _mm512_setzero_ps()};
+    __m512 saved_x[2] = {_mm512_setzero_ps(), _mm512_setzero_ps()};
+    __m512 saved_y[2] = {_mm512_setzero_ps(), _mm512_setzero_ps()};
+    __m512 dz_x[2] = {_mm512_set1_ps(1.0f), _mm512_set1_ps(1.0f)};
+    __m512 dz_y[2] = {_mm512_setzero_ps(), _mm512_setzero_ps()};
+    __m512i counter[2];
+    __m512 two = _mm512_set1_ps(2.0f);
+    __m512 four = _mm512_set1_ps(4.0f);
+    __m512 epsilon = _mm512_set1_ps(KERNEL_PERIODICITY_EPSILON_F32);
+    __m512 attraction = _mm512_set1_ps((f32) KERNEL_ATTRACTION_EPSILON);
+    __m512i one = _mm512_set1_epi32(1);
+    __m512i limit = _mm512_set1_epi32((s32) max_iterations);
+
+    // Lanes inside the cardioid or bulb start out finished at max_iterations
+    __mmask16 interior[2];
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 v = 0; v < 2; v++) {
+        interior[v] = kernel_avx512_f32_interior(active[v], c_x[v], c_y[v]);
+        active[v] &= (__mmask16) ~interior[v];
+        counter[v] = _mm512_maskz_mov_epi32(interior[v], limit);
+    }
+
+    // Nothing left to iterate once every lane was rejected
+    for (u32 iteration = (active[0] | active[1]) == 0 ? max_iterations : 0; iteration < max_iterations;
+         ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            // No fused multiply-add here, the rounding has to match the shader
+            __m512 x = _mm512_sub_ps(_mm512_mul_ps(z_x[v], z_x[v]), _mm512_mul_ps(z_y[v], z_y[v]));
+            __m512 y = _mm512_mul_ps(_mm512_mul_ps(two, z_x[v]), z_y[v]);
+            __m512 magnitude = _mm512_add_ps(_mm512_mul_ps(x, x), _mm512_mul_ps(y, y));
+
+            // The compare is evaluated under the active mask, escaped lanes drop out
+            // and the masked operations below leave them untouched. z is updated under
+            // the mask from before the compare, a lane that escapes now is done anyway
+            // and this keeps the compare off the critical path of the recurrence
+            __mmask16 live = active[v];
+            active[v] = _mm512_mask_cmp_ps_mask(active[v], magnitude, four, _CMP_NGT_UQ);
+            counter[v] = _mm512_mask_add_epi32(counter[v], active[v], counter[v], one);
+            z_x[v] = _mm512_mask_add_ps(z_x[v], live, x, c_x[v]);
+            z_y[v] = _mm512_mask_add_ps(z_y[v], live, y, c_y[v]);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                // Lanes whose derivative collapsed are drawn into a cycle and finish at max_iterations
+                __m512 dx = _mm512_sub_ps(_mm512_mul_ps(z_x[v], dz_x[v]), _mm512_mul_ps(z_y[v], dz_y[v]));
+                __m512 dy = _mm512_add_ps(_mm512_mul_ps(z_x[v], dz_y[v]), _mm512_mul_ps(z_y[v], dz_x[v]));
+                dz_x[v] = _mm512_mul_ps(two, dx);
+                dz_y[v] = _mm512_mul_ps(two, dy);
+                __m512 derivative = _mm512_add_ps(_mm512_mul_ps(dz_x[v], dz_x[v]), _mm512_mul_ps(dz_y[v], dz_y[v]));
+                __mmask16 attracted_lanes = _mm512_mask_cmp_ps_mask(active[v], derivative, attraction, _CMP_LT_OQ);
+                counter[v] = _mm512_mask_mov_epi32(counter[v], attracted_lanes, limit);
+                active[v] &= (__mmask16) ~attracted_lanes;
+                attracted += u32_popcount(attracted_lanes);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                // Lanes that came back to the saved value finish at max_iterations
+                __mmask16 cycle =
+                        _mm512_mask_cmp_ps_mask(active[v], _mm512_abs_ps(_mm512_sub_ps(z_x[v], saved_x[v])), epsilon,
+                                                _CMP_LT_OQ);
+                cycle = _mm512_mask_cmp_ps_mask(cycle, _mm512_abs_ps(_mm512_sub_ps(z_y[v], saved_y[v])), epsilon,
+                                                _CMP_LT_OQ);
+                counter[v] = _mm512_mask_mov_epi32(counter[v], cycle, limit);
+                active[v] &= (__mmask16) ~cycle;
+                periodic += u32_popcount(cycle);
+            }
+        }
+        if ((checks & KERNEL_CHECK_PERIODICITY) && (iteration & (iteration + 1)) == 0) {
+            for (u32 v = 0; v < 2; v++) {
+                saved_x[v] = z_x[v];
+                saved_y[v] = z_y[v];
+            }
+        }
+        if ((active[0] | active[1]) == 0) {
+            break;
+        }
+    }
+    _mm512_mask_storeu_epi32(iterations, kernel_avx512_mask16(count), counter[0]);
+    _mm512_mask_storeu_epi32(iterations + 16, kernel_avx512_mask16(count > 16 ? count - 16 : 0), counter[1]);
+    stats->rejected += u32_popcount(interior[0]) + u32_popcount(interior[1]);
+    stats->periodic += periodic;
+    stats->attracted += attracted;
+}
+
+static void kernel_avx512_f64_lanes(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 checks,
+                                    u32 *iterations, kernel_stats_t *stats) {
+    __mmask8 active[2] = {kernel_avx512_mask8(count), kernel_avx512_mask8(count > 8 ? count - 8 : 0)};
+    __m512d c_x[2] = {_mm512_maskz_loadu_pd(active[0], cx), _mm512_maskz_loadu_pd(active[1], cx + 8)};
+    __m512d c_y[2] = {_mm512_maskz_loadu_pd(active[0], cy), _mm512_maskz_loadu_pd(active[1], cy + 8)};
+    __m512d z_x[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d z_y[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d saved_x[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d saved_y[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d dz_x[2] = {_mm512_set1_pd(1.0), _mm512_set1_pd(1.0)};
+    __m512d dz_y[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512i counter[2];
+    __m512d two = _mm512_set1_pd(2.0);
+    __m512d four = _mm512_set1_pd(4.0);
+    __m512d epsilon = _mm512_set1_pd(KERNEL_PERIODICITY_EPSILON_F64);
+    __m512d attraction = _mm512_set1_pd(KERNEL_ATTRACTION_EPSILON);
+    __m512i one = _mm512_set1_epi64(1);
+    __m512i limit = _mm512_set1_epi64(max_iterations);
+
+    __mmask8 interior[2];
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 v = 0; v < 2; v++) {
+        interior[v] = kernel_avx512_f64_interior(active[v], c_x[v], c_y[v], 0.0);
+        active[v] &= (__mmask8) ~interior[v];
+        counter[v] = _mm512_maskz_mov_epi64(interior[v], limit);
+    }
+
+    for (u32 iteration = (active[0] | active[1]) == 0 ? max_iterations : 0; iteration < max_iterations;
+         ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            __m512d x = _mm512_sub_pd(_mm512_mul_pd(z_x[v], z_x[v]), _mm512_mul_pd(z_y[v], z_y[v]));
+            __m512d y = _mm512_mul_pd(_mm512_mul_pd(two, z_x[v]), z_y[v]);
+            __m512d magnitude = _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y));
+            __mmask8 live = active[v];
+            active[v] = _mm512_mask_cmp_pd_mask(active[v], magnitude, four, _CMP_NGT_UQ);
+            counter[v] = _mm512_mask_add_epi64(counter[v], active[v], counter[v], one);
+            z_x[v] = _mm512_mask_add_pd(z_x[v], live, x, c_x[v]);
+            z_y[v] = _mm512_mask_add_pd(z_y[v], live, y, c_y[v]);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                __m512d dx = _mm512_sub_pd(_mm512_mul_pd(z_x[v], dz_x[v]), _mm512_mul_pd(z_y[v], dz_y[v]));
+                __m512d dy = _mm512_add_pd(_mm512_mul_pd(z_x[v], dz_y[v]), _mm512_mul_pd(z_y[v], dz_x[v]));
+                dz_x[v] = _mm512_mul_pd(two, dx);
+                dz_y[v] = _mm512_mul_pd(two, dy);
+                __m512d derivative = _mm512_add_pd(_mm512_mul_pd(dz_x[v], dz_x[v]), _mm512_mul_pd(dz_y[v], dz_y[v]));
+                __mmask8 attracted_lanes = _mm512_mask_cmp_pd_mask(active[v], derivative, attraction, _CMP_LT_OQ);
+                counter[v] = _mm512_mask_mov_epi64(counter[v], attracted_lanes, limit);
+                active[v] &= (__mmask8) ~attracted_lanes;
+                attracted += u32_popcount(attracted_lanes);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                __mmask8 cycle =
+                        _mm512_mask_cmp_pd_mask(active[v], _mm512_abs_pd(_mm512_sub_pd(z_x[v], saved_x[v])), epsilon,
+                                                _CMP_LT_OQ);
+                cycle = _mm512_mask_cmp_pd_mask(cycle, _mm512_abs_pd(_mm512_sub_pd(z_y[v], saved_y[v])), epsilon,
+                                                _CMP_LT_OQ);
+                counter[v] = _mm512_mask_mov_epi64(counter[v], cycle, limit);
+                active[v] &= (__mmask8) ~cycle;
+                periodic += u32_popcount(cycle);
+            }
+        }
+        if ((checks & KERNEL_CHECK_PERIODICITY) && (iteration & (iteration + 1)) == 0) {
+            for (u32 v = 0; v < 2; v++) {
+                saved_x[v] = z_x[v];
+                saved_y[v] = z_y[v];
+            }
+        }
+        if ((active[0] | active[1]) == 0) {
+            break;
+        }
+    }
+    _mm512_mask_cvtepi64_storeu_epi32(iterations, kernel_avx512_mask8(count), counter[0]);
+    _mm512_mask_cvtepi64_storeu_epi32(iterations + 8, kernel_avx512_mask8(count > 8 ? count - 8 : 0), counter[1]);
+    stats->rejected += u32_popcount(interior[0]) + u32_popcount(interior[1]);
+    stats->periodic += periodic;
+    stats->attracted += attracted;
+}
+
+static void kernel_avx512_f32(const f32 *cx, const f32 *cy, u32 count, u32 max_iterations, u32 checks,
+                              u32 *iterations, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i += KERNEL_AVX512_F32_LANES) {
+        kernel_avx512_f32_lanes(cx + i, cy + i, count - i, max_iterations, checks, iterations + i, stats);
+    }
+}
+
+static void kernel_avx512_f64(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 checks,
+                              u32 *iterations, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i += KERNEL_AVX512_F64_LANES) {
+        kernel_avx512_f64_lanes(cx + i, cy + i, count - i, max_iterations, checks, iterations + i, stats);
+    }
+}
+
+// ===================================================================================
+// AVX-512 DOUBLE-DOUBLE KERNEL
+// ===================================================================================
+
+#define KERNEL_AVX512_DDOUBLE_LANES 8
+
+typedef struct kernel_avx512_ddouble {
+    __m512d hi;
+    __m512d lo;
+} kernel_avx512_ddouble_t;
+
+static inline kernel_avx512_ddouble_t kernel_avx512_ddouble_add(kernel_avx512_ddouble_t a,
+                                                                kernel_avx512_ddouble_t b) {
+    // Same steps as the scalar kernel, two-sum of both parts followed by renormalization
+    __m512d s = _mm512_add_pd(a.hi, b.hi);
+    __m512d v = _mm512_sub_pd(s, a.hi);
+    __m512d e = _mm512_add_pd(_mm512_sub_pd(a.hi, _mm512_sub_pd(s, v)), _mm512_sub_pd(b.hi, v));
+    __m512d t = _mm512_add_pd(a.lo, b.lo);
+    __m512d w = _mm512_sub_pd(t, a.lo);
+    __m512d f = _mm512_add_pd(_mm512_sub_pd(a.lo, _mm512_sub_pd(t, w)), _mm512_sub_pd(b.lo, w));
+    e = _mm512_add_pd(e, t);
+    __m512d hi = _mm512_add_pd(s, e);
+    e = _mm512_sub_pd(e, _mm512_sub_pd(hi, s));
+    e = _mm512_add_pd(e, f);
+
+    kernel_avx512_ddouble_t result;
+    result.hi = _mm512_add_pd(hi, e);
+    result.lo = _mm512_sub_pd(e, _mm512_sub_pd(result.hi, hi));
+    return result;
+}
+
+static inline kernel_avx512_ddouble_t kernel_avx512_ddouble_mul(kernel_avx512_ddouble_t a,
+                                                                kernel_avx512_ddouble_t b) {
+    // The fused multiply-subtract yields the exact rounding error of the product
+    __m512d p = _mm512_mul_pd(a.hi, b.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, b.hi, p);
+    e = _mm512_add_pd(e, _mm512_add_pd(_mm512_mul_pd(a.hi, b.lo), _mm512_mul_pd(a.lo, b.hi)));
+
+    kernel_avx512_ddouble_t result;
+    result.hi = _mm512_add_pd(p, e);
+    result.lo = _mm512_sub_pd(e, _mm512_sub_pd(result.hi, p));
+    return result;
+}
+
+static void kernel_avx512_ddouble(const ddouble_t *cx, const ddouble_t *cy, u32 count, u32 max_iterations,
+                                  u32 checks, u32 *iterations, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i += KERNEL_AVX512_DDOUBLE_LANES) {
+        // Points are transposed into separate high and low parts, lanes past count start out inactive
+        __mmask8 active = kernel_avx512_mask8(count - i);
+
+        f64 lanes[4][KERNEL_AVX512_DDOUBLE_LANES];
+        for (u32 lane = 0; lane < KERNEL_AVX512_DDOUBLE_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            lanes[0][lane] = cx[index].hi;
+            lanes[1][lane] = cx[index].lo;
+            lanes[2][lane] = cy[index].hi;
+            lanes[3][lane] = cy[index].lo;
+        }
+        kernel_avx512_ddouble_t c_x = {_mm512_loadu_pd(lanes[0]), _mm512_loadu_pd(lanes[1])};
+        kernel_avx512_ddouble_t c_y = {_mm512_loadu_pd(lanes[2]), _mm512_loadu_pd(lanes[3])};
+        kernel_avx512_ddouble_t z_x = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+        kernel_avx512_ddouble_t z_y = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+        kernel_avx512_ddouble_t saved_x = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+        kernel_avx512_ddouble_t saved_y = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+        __m512d dz_x = _mm512_set1_pd(1.0);
+        __m512d dz_y = _mm512_setzero_pd();
+        __m512d two = _mm512_set1_pd(2.0);
+        __m512d four = _mm512_set1_pd(4.0);
+        __m512d epsilon = _mm512_set1_pd(KERNEL_PERIODICITY_EPSILON_DDOUBLE);
+        __m512d attraction = _mm512_set1_pd(KERNEL_ATTRACTION_EPSILON);
+        __m512i limit = _mm512_set1_epi64(max_iterations);
+        __m512i one = _mm512_set1_epi64(1);
+        __m512i sign = _mm512_set1_epi64((s64) 0x8000000000000000ull);
+
+        // Membership is decided on the high parts, points within the margin are iterated
+        __mmask8 interior = kernel_avx512_f64_interior(active, c_x.hi, c_y.hi, KERNEL_INTERIOR_MARGIN);
+        __m512i counter = _mm512_maskz_mov_epi64(interior, limit);
+        active &= (__mmask8) ~interior;
+        stats->rejected += u32_popcount(interior);
+
+        for (u32 iteration = 0; iteration < max_iterations; ++iteration) {
+            kernel_avx512_ddouble_t xx = kernel_avx512_ddouble_mul(z_x, z_x);
+            kernel_avx512_ddouble_t yy = kernel_avx512_ddouble_mul(z_y, z_y);
+            kernel_avx512_ddouble_t xy = kernel_avx512_ddouble_mul(z_x, z_y);
+            yy.hi = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(yy.hi), sign));
+            yy.lo = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(yy.lo), sign));
+            kernel_avx512_ddouble_t x = kernel_avx512_ddouble_add(xx, yy);
+            kernel_avx512_ddouble_t y = {_mm512_mul_pd(two, xy.hi), _mm512_mul_pd(two, xy.lo)};
+
+            __m512d magnitude = _mm512_add_pd(_mm512_mul_pd(x.hi, x.hi), _mm512_mul_pd(y.hi, y.hi));
+            active = _mm512_mask_cmp_pd_mask(active, magnitude, four, _CMP_NGT_UQ);
+            if (active == 0) {
+                break;
+            }
+            counter = _mm512_mask_add_epi64(counter, active, counter, one);
+            z_x = kernel_avx512_ddouble_add(x, c_x);
+            z_y = kernel_avx512_ddouble_add(y, c_y);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                __m512d dx = _mm512_sub_pd(_mm512_mul_pd(z_x.hi, dz_x), _mm512_mul_pd(z_y.hi, dz_y));
+                __m512d dy = _mm512_add_pd(_mm512_mul_pd(z_x.hi, dz_y), _mm512_mul_pd(z_y.hi, dz_x));
+                dz_x = _mm512_mul_pd(two, dx);
+                dz_y = _mm512_mul_pd(two, dy);
+                __m512d derivative = _mm512_add_pd(_mm512_mul_pd(dz_x, dz_x), _mm512_mul_pd(dz_y, dz_y));
+                __mmask8 attracted = _mm512_mask_cmp_pd_mask(active, derivative, attraction, _CMP_LT_OQ);
+                counter = _mm512_mask_mov_epi64(counter, attracted, limit);
+                active &= (__mmask8) ~attracted;
+                stats->attracted += u32_popcount(attracted);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                __m512d distance_x =
+                        _mm512_add_pd(_mm512_sub_pd(z_x.hi, saved_x.hi), _mm512_sub_pd(z_x.lo, saved_x.lo));
+                __m512d distance_y =
+                        _mm512_add_pd(_mm512_sub_pd(z_y.hi, saved_y.hi), _mm512_sub_pd(z_y.lo, saved_y.lo));
+                __mmask8 cycle = _mm512_mask_cmp_pd_mask(active, _mm512_abs_pd(distance_x), epsilon, _CMP_LT_OQ);
+                cycle = _mm512_mask_cmp_pd_mask(cycle, _mm512_abs_pd(distance_y), epsilon, _CMP_LT_OQ);
+                counter = _mm512_mask_mov_epi64(counter, cycle, limit);
+                active &= (__mmask8) ~cycle;
+                stats->periodic += u32_popcount(cycle);
+                if ((iteration & (iteration + 1)) == 0) {
+                    saved_x = z_x;
+                    saved_y = z_y;
+                }
+            }
+        }
+        _mm512_mask_cvtepi64_storeu_epi32(iterations + i, kernel_avx512_mask8(count - i), counter);
+    }
+}
+
+// ===================================================================================
+// AVX-512 DISTANCE KERNEL
+// ===================================================================================
+
+static void kernel_avx512_distance_lanes(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations,
+                                         u32 *iterations, f64 *distances, kernel_stats_t *stats) {
+    __mmask8 valid[2] = {kernel_avx512_mask8(count), kernel_avx512_mask8(count > 8 ? count - 8 : 0)};
+    __m512d c_x[2] = {_mm512_maskz_loadu_pd(valid[0], cx), _mm512_maskz_loadu_pd(valid[1], cx + 8)};
+    __m512d c_y[2] = {_mm512_maskz_loadu_pd(valid[0], cy), _mm512_maskz_loadu_pd(valid[1], cy + 8)};
+    __m512d z_x[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d z_y[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d dz_x[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d dz_y[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512i counter[2];
+    __m512d one = _mm512_set1_pd(1.0);
+    __m512d two = _mm512_set1_pd(2.0);
+    __m512d bailout = _mm512_set1_pd(KERNEL_DISTANCE_BAILOUT);
+    __m512i increment = _mm512_set1_epi64(1);
+
+    __mmask8 active[2];
+    for (u32 v = 0; v < 2; v++) {
+        __mmask8 interior = kernel_avx512_f64_interior(valid[v], c_x[v], c_y[v], 0.0);
+        active[v] = valid[v] & (__mmask8) ~interior;
+        counter[v] = _mm512_maskz_mov_epi64(interior, _mm512_set1_epi64(max_iterations));
+        stats->rejected += u32_popcount(interior);
+    }
+
+    // Escaped lanes have to keep z and dz for the estimate, only active lanes are updated
+    for (u32 iteration = (active[0] | active[1]) == 0 ? max_iterations : 0; iteration < max_iterations;
+         ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            __m512d xx = _mm512_mul_pd(z_x[v], z_x[v]);
+            __m512d yy = _mm512_mul_pd(z_y[v], z_y[v]);
+            active[v] &= (__mmask8) ~_mm512_mask_cmp_pd_mask(active[v], _mm512_add_pd(xx, yy), bailout, _CMP_GT_OQ);
+            counter[v] = _mm512_mask_add_epi64(counter[v], active[v], counter[v], increment);
+            __m512d dx = _mm512_add_pd(
+                    _mm512_mul_pd(two, _mm512_sub_pd(_mm512_mul_pd(z_x[v], dz_x[v]), _mm512_mul_pd(z_y[v], dz_y[v]))),
+                    one);
+            __m512d dy =
+                    _mm512_mul_pd(two, _mm512_add_pd(_mm512_mul_pd(z_x[v], dz_y[v]), _mm512_mul_pd(z_y[v], dz_x[v])));
+            __m512d y = _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(two, z_x[v]), z_y[v]), c_y[v]);
+            z_x[v] = _mm512_mask_add_pd(z_x[v], active[v], _mm512_sub_pd(xx, yy), c_x[v]);
+            z_y[v] = _mm512_mask_mov_pd(z_y[v], active[v], y);
+            dz_x[v] = _mm512_mask_mov_pd(dz_x[v], active[v], dx);
+            dz_y[v] = _mm512_mask_mov_pd(dz_y[v], active[v], dy);
+        }
+        if ((active[0] | active[1]) == 0) {
+            break;
+        }
+    }
+
+    // The logarithm is only needed once per lane
+    u64 result[KERNEL_AVX512_F64_LANES];
+    f64 lanes_z[4][KERNEL_AVX512_F64_LANES];
+    for (u32 v = 0; v < 2; v++) {
+        _mm512_storeu_si512(result + 8 * v, counter[v]);
+        _mm512_storeu_pd(lanes_z[0] + 8 * v, z_x[v]);
+        _mm512_storeu_pd(lanes_z[1] + 8 * v, z_y[v]);
+        _mm512_storeu_pd(lanes_z[2] + 8 * v, dz_x[v]);
+        _mm512_storeu_pd(lanes_z[3] + 8 * v, dz_y[v]);
+    }
+    for (u32 i = 0; i < count && i < KERNEL_AVX512_F64_LANES; i++) {
+        iterations[i] = (u32) result[i];
+        distances[i] = iterations[i] < max_iterations
+                               ? kernel_distance(lanes_z[0][i], lanes_z[1][i], lanes_z[2][i], lanes_z[3][i])
+                               : 0.0;
+    }
+}
+
+static void kernel_avx512_distance(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 *iterations,
+                                   f64 *distances, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i += KERNEL_AVX512_F64_LANES) {
+        kernel_avx512_distance_lanes(cx + i, cy + i, count - i, max_iterations, iterations + i, distances + i, stats);
+    }
+}
+
+const kernel_t kernel_avx512 = {"avx512", kernel_avx512_f32, kernel_avx512_f64, kernel_avx512_ddouble,
+                                kernel_avx512_distance};
+
+#endif
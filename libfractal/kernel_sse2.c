@@ -0,0 +1,287 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "kernel.h"
+#include "math.h"
+
+// SSE2 is part of the x86-64 baseline, no extra compiler flags are needed
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+// ===================================================================================
+// SSE2 KERNEL
+// ===================================================================================
+
+// Each call iterates two independent vectors, see the AVX2 kernel
+#define KERNEL_SSE2_F32_LANES 8
+#define KERNEL_SSE2_F64_LANES 4
+
+static __m128 kernel_sse2_f32_interior(__m128 c_x, __m128 c_y) {
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 quarter = _mm_set1_ps(0.25f);
+    __m128 xq = _mm_sub_ps(c_x, quarter);
+    __m128 yy = _mm_mul_ps(c_y, c_y);
+    __m128 q = _mm_add_ps(_mm_mul_ps(xq, xq), yy);
+    __m128 x1 = _mm_add_ps(c_x, one);
+    __m128 bulb = _mm_add_ps(_mm_mul_ps(x1, x1), yy);
+    __m128 cardioid = _mm_cmplt_ps(_mm_mul_ps(q, _mm_add_ps(q, xq)), _mm_mul_ps(quarter, yy));
+    return _mm_or_ps(cardioid, _mm_cmplt_ps(bulb, _mm_set1_ps(0.0625f)));
+}
+
+static void kernel_sse2_f32_lanes(const f32 *cx, const f32 *cy, u32 lanes, u32 max_iterations, u32 checks,
+                                  u32 *iterations, kernel_stats_t *stats) {
+    __m128 c_x[2] = {_mm_loadu_ps(cx), _mm_loadu_ps(cx + 4)};
+    __m128 c_y[2] = {_mm_loadu_ps(cy), _mm_loadu_ps(cy + 4)};
+    __m128 z_x[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 z_y[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 saved_x[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 saved_y[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 dz_x[2] = {_mm_set1_ps(1.0f), _mm_set1_ps(1.0f)};
+    __m128 dz_y[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 four = _mm_set1_ps(4.0f);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 epsilon = _mm_set1_ps(KERNEL_PERIODICITY_EPSILON_F32);
+    __m128 attraction = _mm_set1_ps((f32) KERNEL_ATTRACTION_EPSILON);
+    __m128i limit = _mm_set1_epi32((s32) max_iterations);
+
+    // Lanes inside the cardioid or bulb start out finished at max_iterations
+    __m128 active[2];
+    __m128i count[2];
+    u32 interior = 0;
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 v = 0; v < 2; v++) {
+        __m128 inside = kernel_sse2_f32_interior(c_x[v], c_y[v]);
+        active[v] = _mm_andnot_ps(inside, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+        count[v] = _mm_and_si128(_mm_castps_si128(inside), limit);
+        interior |= (u32) _mm_movemask_ps(inside) << (4 * v);
+    }
+
+    // Nothing left to iterate once every lane was rejected
+    for (u32 iteration = interior == 0xff ? max_iterations : 0; iteration < max_iterations; ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            __m128 x = _mm_sub_ps(_mm_mul_ps(z_x[v], z_x[v]), _mm_mul_ps(z_y[v], z_y[v]));
+            __m128 y = _mm_mul_ps(_mm_mul_ps(two, z_x[v]), z_y[v]);
+            __m128 magnitude = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+            active[v] = _mm_andnot_ps(_mm_cmpgt_ps(magnitude, four), active[v]);
+            count[v] = _mm_sub_epi32(count[v], _mm_castps_si128(active[v]));
+            z_x[v] = _mm_add_ps(x, c_x[v]);
+            z_y[v] = _mm_add_ps(y, c_y[v]);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                // Lanes whose derivative collapsed are drawn into a cycle and finish at max_iterations
+                __m128 dx = _mm_sub_ps(_mm_mul_ps(z_x[v], dz_x[v]), _mm_mul_ps(z_y[v], dz_y[v]));
+                __m128 dy = _mm_add_ps(_mm_mul_ps(z_x[v], dz_y[v]), _mm_mul_ps(z_y[v], dz_x[v]));
+                dz_x[v] = _mm_mul_ps(two, dx);
+                dz_y[v] = _mm_mul_ps(two, dy);
+                __m128 derivative = _mm_add_ps(_mm_mul_ps(dz_x[v], dz_x[v]), _mm_mul_ps(dz_y[v], dz_y[v]));
+                __m128 attracted_lanes = _mm_and_ps(_mm_cmplt_ps(derivative, attraction), active[v]);
+                count[v] = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(attracted_lanes), count[v]),
+                                        _mm_and_si128(_mm_castps_si128(attracted_lanes), limit));
+                active[v] = _mm_andnot_ps(attracted_lanes, active[v]);
+                attracted |= (u32) _mm_movemask_ps(attracted_lanes) << (4 * v);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                // Lanes that came back to the saved value finish at max_iterations
+                __m128 distance_x = _mm_andnot_ps(sign, _mm_sub_ps(z_x[v], saved_x[v]));
+                __m128 distance_y = _mm_andnot_ps(sign, _mm_sub_ps(z_y[v], saved_y[v]));
+                __m128 cycle = _mm_and_ps(_mm_cmplt_ps(distance_x, epsilon), _mm_cmplt_ps(distance_y, epsilon));
+                cycle = _mm_and_ps(cycle, active[v]);
+                count[v] = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(cycle), count[v]),
+                                        _mm_and_si128(_mm_castps_si128(cycle), limit));
+                active[v] = _mm_andnot_ps(cycle, active[v]);
+                periodic |= (u32) _mm_movemask_ps(cycle) << (4 * v);
+            }
+        }
+        if ((checks & KERNEL_CHECK_PERIODICITY) && (iteration & (iteration + 1)) == 0) {
+            for (u32 v = 0; v < 2; v++) {
+                saved_x[v] = z_x[v];
+                saved_y[v] = z_y[v];
+            }
+        }
+        if (_mm_movemask_ps(_mm_or_ps(active[0], active[1])) == 0) {
+            break;
+        }
+    }
+    _mm_storeu_si128((__m128i *) iterations, count[0]);
+    _mm_storeu_si128((__m128i *) (iterations + 4), count[1]);
+
+    // Padding lanes of the tail are not counted
+    u32 valid = (1u << lanes) - 1;
+    stats->rejected += u32_popcount(interior & valid);
+    stats->periodic += u32_popcount(periodic & valid);
+    stats->attracted += u32_popcount(attracted & valid);
+}
+
+static __m128d kernel_sse2_f64_interior(__m128d c_x, __m128d c_y) {
+    __m128d one = _mm_set1_pd(1.0);
+    __m128d quarter = _mm_set1_pd(0.25);
+    __m128d xq = _mm_sub_pd(c_x, quarter);
+    __m128d yy = _mm_mul_pd(c_y, c_y);
+    __m128d q = _mm_add_pd(_mm_mul_pd(xq, xq), yy);
+    __m128d x1 = _mm_add_pd(c_x, one);
+    __m128d bulb = _mm_add_pd(_mm_mul_pd(x1, x1), yy);
+    __m128d cardioid = _mm_cmplt_pd(_mm_mul_pd(q, _mm_add_pd(q, xq)), _mm_mul_pd(quarter, yy));
+    return _mm_or_pd(cardioid, _mm_cmplt_pd(bulb, _mm_set1_pd(0.0625)));
+}
+
+static void kernel_sse2_f64_lanes(const f64 *cx, const f64 *cy, u32 lanes, u32 max_iterations, u32 checks,
+                                  u32 *iterations, kernel_stats_t *stats) {
+    __m128d c_x[2] = {_mm_loadu_pd(cx), _mm_loadu_pd(cx + 2)};
+    __m128d c_y[2] = {_mm_loadu_pd(cy), _mm_loadu_pd(cy + 2)};
+    __m128d z_x[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d z_y[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d saved_x[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d saved_y[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d dz_x[2] = {_mm_set1_pd(1.0), _mm_set1_pd(1.0)};
+    __m128d dz_y[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d two = _mm_set1_pd(2.0);
+    __m128d four = _mm_set1_pd(4.0);
+    __m128d sign = _mm_set1_pd(-0.0);
+    __m128d epsilon = _mm_set1_pd(KERNEL_PERIODICITY_EPSILON_F64);
+    __m128d attraction = _mm_set1_pd(KERNEL_ATTRACTION_EPSILON);
+    __m128i limit = _mm_set1_epi64x(max_iterations);
+
+    __m128d active[2];
+    __m128i count[2];
+    u32 interior = 0;
+    u32 periodic = 0;
+    u32 attracted = 0;
+    for (u32 v = 0; v < 2; v++) {
+        __m128d inside = kernel_sse2_f64_interior(c_x[v], c_y[v]);
+        active[v] = _mm_andnot_pd(inside, _mm_castsi128_pd(_mm_set1_epi32(-1)));
+        count[v] = _mm_and_si128(_mm_castpd_si128(inside), limit);
+        interior |= (u32) _mm_movemask_pd(inside) << (2 * v);
+    }
+
+    // Nothing left to iterate once every lane was rejected
+    for (u32 iteration = interior == 0xf ? max_iterations : 0; iteration < max_iterations; ++iteration) {
+        for (u32 v = 0; v < 2; v++) {
+            __m128d x = _mm_sub_pd(_mm_mul_pd(z_x[v], z_x[v]), _mm_mul_pd(z_y[v], z_y[v]));
+            __m128d y = _mm_mul_pd(_mm_mul_pd(two, z_x[v]), z_y[v]);
+            __m128d magnitude = _mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y));
+            active[v] = _mm_andnot_pd(_mm_cmpgt_pd(magnitude, four), active[v]);
+            count[v] = _mm_sub_epi64(count[v], _mm_castpd_si128(active[v]));
+            z_x[v] = _mm_add_pd(x, c_x[v]);
+            z_y[v] = _mm_add_pd(y, c_y[v]);
+            if (checks & KERNEL_CHECK_ATTRACTION) {
+                __m128d dx = _mm_sub_pd(_mm_mul_pd(z_x[v], dz_x[v]), _mm_mul_pd(z_y[v], dz_y[v]));
+                __m128d dy = _mm_add_pd(_mm_mul_pd(z_x[v], dz_y[v]), _mm_mul_pd(z_y[v], dz_x[v]));
+                dz_x[v] = _mm_mul_pd(two, dx);
+                dz_y[v] = _mm_mul_pd(two, dy);
+                __m128d derivative = _mm_add_pd(_mm_mul_pd(dz_x[v], dz_x[v]), _mm_mul_pd(dz_y[v], dz_y[v]));
+                __m128d attracted_lanes = _mm_and_pd(_mm_cmplt_pd(derivative, attraction), active[v]);
+                count[v] = _mm_or_si128(_mm_andnot_si128(_mm_castpd_si128(attracted_lanes), count[v]),
+                                        _mm_and_si128(_mm_castpd_si128(attracted_lanes), limit));
+                active[v] = _mm_andnot_pd(attracted_lanes, active[v]);
+                attracted |= (u32) _mm_movemask_pd(attracted_lanes) << (2 * v);
+            }
+            if (checks & KERNEL_CHECK_PERIODICITY) {
+                __m128d distance_x = _mm_andnot_pd(sign, _mm_sub_pd(z_x[v], saved_x[v]));
+                __m128d distance_y = _mm_andnot_pd(sign, _mm_sub_pd(z_y[v], saved_y[v]));
+                __m128d cycle = _mm_and_pd(_mm_cmplt_pd(distance_x, epsilon), _mm_cmplt_pd(distance_y, epsilon));
+                cycle = _mm_and_pd(cycle, active[v]);
+                count[v] = _mm_or_si128(_mm_andnot_si128(_mm_castpd_si128(cycle), count[v]),
+                                        _mm_and_si128(_mm_castpd_si128(cycle), limit));
+                active[v] = _mm_andnot_pd(cycle, active[v]);
+                periodic |= (u32) _mm_movemask_pd(cycle) << (2 * v);
+            }
+        }
+        if ((checks & KERNEL_CHECK_PERIODICITY) && (iteration & (iteration + 1)) == 0) {
+            for (u32 v = 0; v < 2; v++) {
+                saved_x[v] = z_x[v];
+                saved_y[v] = z_y[v];
+            }
+        }
+        if (_mm_movemask_pd(_mm_or_pd(active[0], active[1])) == 0) {
+            break;
+        }
+    }
+
+    u64 result[KERNEL_SSE2_F64_LANES];
+    _mm_storeu_si128((__m128i *) result, count[0]);
+    _mm_storeu_si128((__m128i *) (result + 2), count[1]);
+    for (u32 i = 0; i < KERNEL_SSE2_F64_LANES; i++) {
+        iterations[i] = (u32) result[i];
+    }
+
+    u32 valid = (1u << lanes) - 1;
+    stats->rejected += u32_popcount(interior & valid);
+    stats->periodic += u32_popcount(periodic & valid);
+    stats->attracted += u32_popcount(attracted & valid);
+}
+
+static void kernel_sse2_f32(const f32 *cx, const f32 *cy, u32 count, u32 max_iterations, u32 checks,
+                            u32 *iterations, kernel_stats_t *stats) {
+    u32 i = 0;
+    for (; i + KERNEL_SSE2_F32_LANES <= count; i += KERNEL_SSE2_F32_LANES) {
+        kernel_sse2_f32_lanes(cx + i, cy + i, KERNEL_SSE2_F32_LANES, max_iterations, checks, iterations + i,
+                              stats);
+    }
+
+    // The tail is padded by repeating the last point, only the valid lanes are written back
+    if (i < count) {
+        f32 tail_x[KERNEL_SSE2_F32_LANES];
+        f32 tail_y[KERNEL_SSE2_F32_LANES];
+        u32 tail_iterations[KERNEL_SSE2_F32_LANES];
+        for (u32 lane = 0; lane < KERNEL_SSE2_F32_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            tail_x[lane] = cx[index];
+            tail_y[lane] = cy[index];
+        }
+        kernel_sse2_f32_lanes(tail_x, tail_y, count - i, max_iterations, checks, tail_iterations, stats);
+        for (u32 lane = 0; i + lane < count; lane++) {
+            iterations[i + lane] = tail_iterations[lane];
+        }
+    }
+}
+
+static void kernel_sse2_f64(const f64 *cx, const f64 *cy, u32 count, u32 max_iterations, u32 checks,
+                            u32 *iterations, kernel_stats_t *stats) {
+    u32 i = 0;
+    for (; i + KERNEL_SSE2_F64_LANES <= count; i += KERNEL_SSE2_F64_LANES) {
+        kernel_sse2_f64_lanes(cx + i, cy + i, KERNEL_SSE2_F64_LANES, max_iterations, checks, iterations + i,
+                              stats);
+    }
+
+    if (i < count) {
+        f64 tail_x[KERNEL_SSE2_F64_LANES];
+        f64 tail_y[KERNEL_SSE2_F64_LANES];
+        u32 tail_iterations[KERNEL_SSE2_F64_LANES];
+        for (u32 lane = 0; lane < KERNEL_SSE2_F64_LANES; lane++) {
+            u32 index = i + lane < count ? i + lane : count - 1;
+            tail_x[lane] = cx[index];
+            tail_y[lane] = cy[index];
+        }
+        kernel_sse2_f64_lanes(tail_x, tail_y, count - i, max_iterations, checks, tail_iterations, stats);
+        for (u32 lane = 0; i + lane < count; lane++) {
+            iterations[i + lane] = tail_iterations[lane];
+        }
+    }
+}
+
+const kernel_t kernel_sse2 = {"sse2", kernel_sse2_f32, kernel_sse2_f64, NULL, NULL};
+
+#endif
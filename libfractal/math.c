@@ -36,6 +36,14 @@ s32 s32_clamp(s32 n, s32 min, s32 max) {
     return s32_min(max, s32_max(n, min));
 }
 
+u32 u32_popcount(u32 n) {
+    u32 count = 0;
+    for (; n; n &= n - 1) {
+        count++;
+    }
+    return count;
+}
+
 void f32mat4_create_identity(f32mat4_t *self) {
     self->value[0].x = 1.0f;
     self->value[0].y = 0.0f;
@@ -63,3 +71,66 @@ void f32mat4_create_orthogonal(f32mat4_t *self, f32 left, f32 right, f32 bottom,
     self->value[3].x = -(right + left) / (right - left);
     self->value[3].y = -(top + bottom) / (top - bottom);
 }
+
+// ===================================================================================
+// DOUBLE-DOUBLE
+// ===================================================================================
+
+// Dekker's splitter for the 53 bit mantissa, 2^27 + 1
+#define DDOUBLE_SPLITTER 134217729.0
+
+static ddouble_t ddouble_quick_two_sum(f64 a, f64 b) {
+    ddouble_t result;
+    result.hi = a + b;
+    result.lo = b - (result.hi - a);
+    return result;
+}
+
+static ddouble_t ddouble_two_sum(f64 a, f64 b) {
+    ddouble_t result;
+    result.hi = a + b;
+    f64 v = result.hi - a;
+    result.lo = (a - (result.hi - v)) + (b - v);
+    return result;
+}
+
+ddouble_t ddouble_create(f64 value) {
+    ddouble_t result = {value, 0.0};
+    return result;
+}
+
+ddouble_t ddouble_product(f64 a, f64 b) {
+    // Dekker's algorithm, exact as long as nothing overflows
+    f64 t = DDOUBLE_SPLITTER * a;
+    f64 a_hi = t - (t - a);
+    f64 a_lo = a - a_hi;
+    t = DDOUBLE_SPLITTER * b;
+    f64 b_hi = t - (t - b);
+    f64 b_lo = b - b_hi;
+
+    ddouble_t result;
+    result.hi = a * b;
+    result.lo = ((a_hi * b_hi - result.hi) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+    return result;
+}
+
+ddouble_t ddouble_add(ddouble_t a, ddouble_t b) {
+    ddouble_t s = ddouble_two_sum(a.hi, b.hi);
+    ddouble_t t = ddouble_two_sum(a.lo, b.lo);
+    s.lo += t.hi;
+    s = ddouble_quick_two_sum(s.hi, s.lo);
+    s.lo += t.lo;
+    return ddouble_quick_two_sum(s.hi, s.lo);
+}
+
+ddouble_t ddouble_sub(ddouble_t a, ddouble_t b) {
+    b.hi = -b.hi;
+    b.lo = -b.lo;
+    return ddouble_add(a, b);
+}
+
+ddouble_t ddouble_mul(ddouble_t a, ddouble_t b) {
+    ddouble_t p = ddouble_product(a.hi, b.hi);
+    p.lo += a.hi * b.lo + a.lo * b.hi;
+    return ddouble_quick_two_sum(p.hi, p.lo);
+}
@@ -55,6 +55,14 @@ s32 s32_min(s32 a, s32 b);
  */
 s32 s32_clamp(s32 n, s32 min, s32 max);
 
+/**
+ * Counts the set bits of the specified value
+ *
+ * @param n value
+ * @return number of set bits
+ */
+u32 u32_popcount(u32 n);
+
 /**
  * Creates an identity matrix
  *
@@ -74,4 +82,48 @@ void f32mat4_create_identity(f32mat4_t *self);
  */
 void f32mat4_create_orthogonal(f32mat4_t *self, f32 left, f32 right, f32 bottom, f32 top);
 
+/**
+ * Creates a double-double from a double
+ *
+ * @param value value
+ * @return double-double
+ */
+ddouble_t ddouble_create(f64 value);
+
+/**
+ * Computes the exact product of two doubles as a double-double
+ *
+ * @param a first factor
+ * @param b second factor
+ * @return a * b
+ */
+ddouble_t ddouble_product(f64 a, f64 b);
+
+/**
+ * Adds two double-doubles
+ *
+ * @param a first summand
+ * @param b second summand
+ * @return a + b
+ */
+ddouble_t ddouble_add(ddouble_t a, ddouble_t b);
+
+/**
+ * Subtracts two double-doubles
+ *
+ * @param a minuend
+ * @param b subtrahend
+ * @return a - b
+ */
+ddouble_t ddouble_sub(ddouble_t a, ddouble_t b);
+
+/**
+ * Multiplies two double-doubles
+ *
+ * @param a first factor
+ * @param b second factor
+ * @return a * b
+ */
+ddouble_t ddouble_mul(ddouble_t a, ddouble_t b);
+
 #endif// #define LIBFRACTAL_MATH_H
@@ -0,0 +1,510 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed.h"
+#include "math.h"
+#include "perturb.h"
+
+// Bits of the reference orbit beyond the pixel spacing
+#define PERTURB_GUARD_BITS 64
+
+// Tiles that are handed to the pool
+#define PERTURB_TILE 32
+
+// The highest series term has to stay this small relative to the linear term
+#define PERTURB_SERIES_TOLERANCE 1e-12
+
+// Maximum relative deviation of a probe from its perturbed orbit
+#define PERTURB_PROBE_TOLERANCE 1e-6
+
+// Probes sit on the corners and edge midpoints where the series is least accurate, and on
+// the center and an inner ring where structures the border does not reach may escape first
+#define PERTURB_PROBES 13
+
+// Relative size of the dropped quadratic term for a single approximated step, kept
+// below double rounding so approximated pixels are as accurate as iterated ones
+#define PERTURB_BLA_EPSILON 0x1p-53
+
+// ===================================================================================
+// REFERENCE ORBIT
+// ===================================================================================
+
+static void perturb_orbit_reserve(perturb_t *self, u32 capacity) {
+    if (capacity > self->orbit_capacity) {
+        f64vec2_t *orbit = realloc(self->orbit, capacity * sizeof(f64vec2_t));
+        ASSERT(orbit, "[perturb] failed to allocate reference orbit of %u iterations\n", capacity);
+        self->orbit = orbit;
+        self->orbit_capacity = capacity;
+    }
+}
+
+static void perturb_orbit_compute(perturb_t *self, u32 max_iterations) {
+    u32 count = self->limb_count;
+    perturb_orbit_reserve(self, max_iterations + 1);
+
+    // z_{n+1} = z_n^2 + c in fixed point, only the rounded orbit is kept. The reference
+    // runs until it has clearly escaped, every pixel bails out at |z|^2 > 2 before that
+    fixed_t z_x, z_y;
+    fixed_zero(&z_x);
+    fixed_zero(&z_y);
+    u32 length = 0;
+    for (;;) {
+        f64 x = fixed_to_f64(&z_x, count);
+        f64 y = fixed_to_f64(&z_y, count);
+        self->orbit[length].x = x;
+        self->orbit[length].y = y;
+        length++;
+        if (length > max_iterations || x * x + y * y > 4.0) {
+            break;
+        }
+        fixed_mandelbrot_step(&z_x, &z_y, &self->center_x, &self->center_y, count);
+    }
+    self->orbit_length = length;
+    self->orbit_iterations = max_iterations;
+    self->orbit_valid = true;
+}
+
+// ===================================================================================
+// SERIES APPROXIMATION
+// ===================================================================================
+
+static f64vec2_t perturb_complex_mul(f64vec2_t a, f64vec2_t b) {
+    f64vec2_t result = {a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x};
+    return result;
+}
+
+static f64vec2_t perturb_complex_add(f64vec2_t a, f64vec2_t b) {
+    f64vec2_t result = {a.x + b.x, a.y + b.y};
+    return result;
+}
+
+static f64 perturb_complex_norm(f64vec2_t a) {
+    return a.x * a.x + a.y * a.y;
+}
+
+static f64vec2_t perturb_series_evaluate(const f64vec2_t *coefficients, f64vec2_t u) {
+    // Horner's scheme, dz = u * (b_1 + u * (b_2 + ...))
+    f64vec2_t result = coefficients[PERTURB_SERIES_TERMS - 1];
+    for (u32 k = PERTURB_SERIES_TERMS - 1; k-- > 0;) {
+        result = perturb_complex_add(perturb_complex_mul(result, u), coefficients[k]);
+    }
+    return perturb_complex_mul(result, u);
+}
+
+static void perturb_series_compute(perturb_t *self, const fractal_view_t *view) {
+    // dz_n = sum b_k u^k with u = dc / radius, the coefficients are scaled by radius^k so
+    // they stay in range at any depth. With z_{n+1} = 2 Z_n dz_n + dz_n^2 + dc:
+    //   b_1' = 2 Z b_1 + radius
+    //   b_k' = 2 Z b_k + sum_{i + j = k} b_i b_j
+    f64 half_width = 0.5 * (f64) view->width * view->scale;
+    f64 half_height = 0.5 * (f64) view->height * view->scale;
+    self->series_radius = sqrt(half_width * half_width + half_height * half_height);
+    self->series_skip = 0;
+    memset(self->series_coefficients, 0, sizeof self->series_coefficients);
+    if (!self->series) {
+        return;
+    }
+
+    // Probes are iterated with plain perturbation alongside, their deviation from the
+    // series is the actual validity check for this frame
+    f64vec2_t probes_dc[PERTURB_PROBES];
+    f64vec2_t probes_dz[PERTURB_PROBES];
+    static const f64 probes[PERTURB_PROBES][2] = {
+            {-1.0, -1.0}, {0.0, -1.0}, {1.0, -1.0}, {-1.0, 0.0}, {1.0, 0.0}, {-1.0, 1.0}, {0.0, 1.0}, {1.0, 1.0},
+            {0.0, 0.0},   {-0.5, -0.5}, {0.5, -0.5}, {-0.5, 0.5}, {0.5, 0.5},
+    };
+    for (u32 i = 0; i < PERTURB_PROBES; i++) {
+        probes_dc[i].x = probes[i][0] * half_width;
+        probes_dc[i].y = probes[i][1] * half_height;
+        probes_dz[i].x = 0.0;
+        probes_dz[i].y = 0.0;
+    }
+
+    f64vec2_t coefficients[PERTURB_SERIES_TERMS];
+    memset(coefficients, 0, sizeof coefficients);
+    u32 limit = (u32) s32_min((s32) view->max_iterations, (s32) self->orbit_length - 1);
+    for (u32 n = 0; n < limit; n++) {
+        f64vec2_t reference = self->orbit[n];
+        f64vec2_t twice = {2.0 * reference.x, 2.0 * reference.y};
+
+        f64vec2_t next[PERTURB_SERIES_TERMS];
+        for (u32 k = 0; k < PERTURB_SERIES_TERMS; k++) {
+            next[k] = perturb_complex_mul(twice, coefficients[k]);
+            for (u32 i = 0; i + 1 <= k; i++) {
+                next[k] = perturb_complex_add(next[k], perturb_complex_mul(coefficients[i], coefficients[k - 1 - i]));
+            }
+        }
+        next[0].x += self->series_radius;
+
+        f64 linear = perturb_complex_norm(next[0]);
+        f64 highest = perturb_complex_norm(next[PERTURB_SERIES_TERMS - 1]);
+        if (!isfinite(linear) || !isfinite(highest) ||
+            highest > PERTURB_SERIES_TOLERANCE * PERTURB_SERIES_TOLERANCE * linear) {
+            break;
+        }
+
+        bool valid = true;
+        for (u32 i = 0; i < PERTURB_PROBES && valid; i++) {
+            f64vec2_t dz = probes_dz[i];
+            f64vec2_t step = perturb_complex_add(perturb_complex_mul(twice, dz), perturb_complex_mul(dz, dz));
+            probes_dz[i] = perturb_complex_add(step, probes_dc[i]);
+
+            f64vec2_t u = {probes_dc[i].x / self->series_radius, probes_dc[i].y / self->series_radius};
+            f64vec2_t approximation = perturb_series_evaluate(next, u);
+            f64vec2_t deviation = {approximation.x - probes_dz[i].x, approximation.y - probes_dz[i].y};
+            f64vec2_t z = perturb_complex_add(self->orbit[n + 1], probes_dz[i]);
+            valid = perturb_complex_norm(deviation) <=
+                            PERTURB_PROBE_TOLERANCE * PERTURB_PROBE_TOLERANCE * perturb_complex_norm(probes_dz[i]) &&
+                    perturb_complex_norm(z) <= 2.0;
+        }
+        if (!valid) {
+            break;
+        }
+        memcpy(coefficients, next, sizeof coefficients);
+        self->series_skip = n + 1;
+    }
+    memcpy(self->series_coefficients, coefficients, sizeof coefficients);
+}
+
+// ===================================================================================
+// BILINEAR APPROXIMATION
+// ===================================================================================
+
+static void perturb_bla_reserve(perturb_t *self, u32 capacity) {
+    if (capacity > self->bla_capacity) {
+        perturb_bla_t *table = realloc(self->bla_table, capacity * sizeof(perturb_bla_t));
+        ASSERT(table, "[perturb] failed to allocate approximation table of %u entries\n", capacity);
+        self->bla_table = table;
+        self->bla_capacity = capacity;
+    }
+}
+
+static void perturb_bla_compute(perturb_t *self) {
+    // A single step dz' = 2 Z dz + dz^2 + dc is linear as long as dz^2 is negligible
+    // against 2 Z dz, that is |dz| < epsilon |2 Z|
+    u32 count = self->orbit_length > 1 ? self->orbit_length - 1 : 0;
+    perturb_bla_reserve(self, 2 * count + 1);
+    self->bla_levels = 0;
+    self->bla_radius = self->series_radius;
+    self->bla_valid = true;
+    if (count == 0) {
+        return;
+    }
+    for (u32 m = 0; m < count; m++) {
+        perturb_bla_t *step = &self->bla_table[m];
+        step->a.x = 2.0 * self->orbit[m].x;
+        step->a.y = 2.0 * self->orbit[m].y;
+        step->b.x = 1.0;
+        step->b.y = 0.0;
+        step->radius = PERTURB_BLA_EPSILON * sqrt(perturb_complex_norm(step->a));
+    }
+    self->bla_offsets[0] = 0;
+    self->bla_counts[0] = count;
+    self->bla_levels = 1;
+
+    // Two adjacent approximations x then y merge into dz'' = a_y (a_x dz + b_x dc) + b_y dc,
+    // valid while x is and the offset x produces stays within the radius of y. Pixels skip
+    // the bailout test in between, so merging is only allowed where none can escape there
+    f64 bailout = 2.0 / ((1.0 + 2.0 * PERTURB_BLA_EPSILON) * (1.0 + 2.0 * PERTURB_BLA_EPSILON));
+    while (self->bla_levels < PERTURB_BLA_LEVELS && self->bla_counts[self->bla_levels - 1] >= 2) {
+        u32 level = self->bla_levels;
+        const perturb_bla_t *source = &self->bla_table[self->bla_offsets[level - 1]];
+        perturb_bla_t *target = &self->bla_table[self->bla_offsets[level - 1] + self->bla_counts[level - 1]];
+        u32 merged = self->bla_counts[level - 1] / 2;
+        for (u32 i = 0; i < merged; i++) {
+            const perturb_bla_t *x = &source[2 * i];
+            const perturb_bla_t *y = &source[2 * i + 1];
+            f64 a_x = sqrt(perturb_complex_norm(x->a));
+            f64 b_x = sqrt(perturb_complex_norm(x->b));
+            f64 radius = a_x > 0.0 ? (y->radius - b_x * self->bla_radius) / a_x : 0.0;
+            if (perturb_complex_norm(self->orbit[(2 * i + 1) << (level - 1)]) > bailout) {
+                radius = 0.0;
+            }
+            target[i].a = perturb_complex_mul(y->a, x->a);
+            target[i].b = perturb_complex_add(perturb_complex_mul(y->a, x->b), y->b);
+            target[i].radius = fmin(x->radius, fmax(0.0, radius));
+        }
+        self->bla_offsets[level] = (u32) (target - self->bla_table);
+        self->bla_counts[level] = merged;
+        self->bla_levels++;
+    }
+}
+
+static const perturb_bla_t *perturb_bla_lookup(const perturb_t *self, u32 iteration, f64 dz_norm, u32 *length) {
+    // Iteration m can start approximations of 2^k steps for every 2^k dividing m,
+    // the longest valid one wins
+    u32 level = 0;
+    while (level + 1 < self->bla_levels && (iteration & ((1u << (level + 1)) - 1)) == 0) {
+        level++;
+    }
+    for (;;) {
+        u32 index = iteration >> level;
+        if (index < self->bla_counts[level]) {
+            const perturb_bla_t *bla = &self->bla_table[self->bla_offsets[level] + index];
+            if (dz_norm < bla->radius * bla->radius) {
+                *length = 1u << level;
+                return bla;
+            }
+        }
+        if (level == 0) {
+            return NULL;
+        }
+        level--;
+    }
+}
+
+// ===================================================================================
+// PERTURBATION
+// ===================================================================================
+
+void perturb_create(perturb_t *self) {
+    fixed_zero(&self->center_x);
+    fixed_zero(&self->center_y);
+    self->limb_count = 0;
+    self->orbit = NULL;
+    self->orbit_length = 0;
+    self->orbit_capacity = 0;
+    self->orbit_iterations = 0;
+    self->orbit_valid = false;
+    self->series = true;
+    memset(self->series_coefficients, 0, sizeof self->series_coefficients);
+    self->series_radius = 0.0;
+    self->series_skip = 0;
+    self->bla = true;
+    self->bla_table = NULL;
+    self->bla_capacity = 0;
+    self->bla_levels = 0;
+    self->bla_radius = 0.0;
+    self->bla_valid = false;
+    self->rebased = 0;
+    self->stats = (kernel_stats_t) {0};
+}
+
+void perturb_destroy(perturb_t *self) {
+    free(self->orbit);
+    self->orbit = NULL;
+    self->orbit_capacity = 0;
+    self->orbit_valid = false;
+    free(self->bla_table);
+    self->bla_table = NULL;
+    self->bla_capacity = 0;
+    self->bla_valid = false;
+}
+
+bool perturb_center(perturb_t *self, const char *x, const char *y) {
+    fixed_t center_x, center_y;
+    if (!fixed_from_string(&center_x, x) || !fixed_from_string(&center_y, y)) {
+        return false;
+    }
+    self->center_x = center_x;
+    self->center_y = center_y;
+    self->orbit_valid = false;
+    return true;
+}
+
+static bool perturb_fixed_equal(const fixed_t *a, const fixed_t *b) {
+    return a->negative == b->negative && memcmp(a->limbs, b->limbs, sizeof a->limbs) == 0;
+}
+
+void perturb_center_view(perturb_t *self, const fractal_view_t *view) {
+    // The orbit is kept if the center did not move, successive calls for the same view are cheap
+    fixed_t center_x, center_y, low;
+    fixed_from_f64(&center_x, view->center_x);
+    fixed_from_f64(&low, view->center_x_low);
+    fixed_add(&center_x, &low, &center_x, FIXED_MAX_LIMBS);
+    fixed_from_f64(&center_y, view->center_y);
+    fixed_from_f64(&low, view->center_y_low);
+    fixed_add(&center_y, &low, &center_y, FIXED_MAX_LIMBS);
+    if (!perturb_fixed_equal(&center_x, &self->center_x) || !perturb_fixed_equal(&center_y, &self->center_y)) {
+        self->center_x = center_x;
+        self->center_y = center_y;
+        self->orbit_valid = false;
+    }
+}
+
+void perturb_series(perturb_t *self, bool enabled) {
+    self->series = enabled;
+}
+
+void perturb_bla(perturb_t *self, bool enabled) {
+    self->bla = enabled;
+}
+
+static u32 perturb_pixel(const perturb_t *self, f64 dc_x, f64 dc_y, u32 max_iterations, bool *rebased) {
+    // z = Z + dz with the reference Z, dz_{n+1} = 2 Z_n dz_n + dz_n^2 + dc, the
+    // series approximation provides dz at series_skip directly
+    f64 dz_x = 0.0;
+    f64 dz_y = 0.0;
+    u32 iteration = self->series_skip;
+    u32 reference = iteration;
+    if (iteration > 0) {
+        f64vec2_t u = {dc_x / self->series_radius, dc_y / self->series_radius};
+        f64vec2_t dz = perturb_series_evaluate(self->series_coefficients, u);
+        dz_x = dz.x;
+        dz_y = dz.y;
+    }
+    *rebased = false;
+    while (iteration < max_iterations) {
+        f64 reference_x = self->orbit[reference].x;
+        f64 reference_y = self->orbit[reference].y;
+        f64 z_x = reference_x + dz_x;
+        f64 z_y = reference_y + dz_y;
+
+        // Same bailout as the shader, which tests |z^2| > 2
+        f64 z_norm = z_x * z_x + z_y * z_y;
+        if (z_norm > 2.0) {
+            return iteration;
+        }
+
+        // Once |z| < |dz| the delta has outgrown the reference and loses precision, which
+        // shows up as glitched blobs. Continuing from the start of the reference with
+        // dz = z avoids that, as does running off the end of an escaped reference
+        if (z_norm < dz_x * dz_x + dz_y * dz_y || reference + 1 == self->orbit_length) {
+            dz_x = z_x;
+            dz_y = z_y;
+            reference = 0;
+            reference_x = self->orbit[0].x;
+            reference_y = self->orbit[0].y;
+            *rebased = true;
+        }
+        if (self->bla) {
+            u32 length;
+            const perturb_bla_t *bla = perturb_bla_lookup(self, reference, dz_x * dz_x + dz_y * dz_y, &length);
+            if (bla && iteration + length <= max_iterations) {
+                f64 x = bla->a.x * dz_x - bla->a.y * dz_y + bla->b.x * dc_x - bla->b.y * dc_y;
+                f64 y = bla->a.x * dz_y + bla->a.y * dz_x + bla->b.x * dc_y + bla->b.y * dc_x;
+                dz_x = x;
+                dz_y = y;
+                iteration += length;
+                reference += length;
+                continue;
+            }
+        }
+        f64 x = 2.0 * (reference_x * dz_x - reference_y * dz_y) + (dz_x * dz_x - dz_y * dz_y) + dc_x;
+        f64 y = 2.0 * (reference_x * dz_y + reference_y * dz_x) + 2.0 * dz_x * dz_y + dc_y;
+        dz_x = x;
+        dz_y = y;
+        ++iteration;
+        ++reference;
+    }
+    return iteration;
+}
+
+typedef struct perturb_job {
+    const perturb_t *perturb;
+    const fractal_view_t *view;
+    u32 *iterations;
+    u32 tiles_x;
+    atomic_uint rebased;
+    atomic_uint rejected;
+} perturb_job_t;
+
+static u32 perturb_evaluate(const perturb_t *self, const fractal_view_t *view, u32 x, u32 y, bool *rebased,
+                            bool *rejected) {
+    // The first reference iteration is the center itself, c is only known to double
+    // precision here which the margin of the membership test accounts for
+    f64 dc_x = ((f64) x + 0.5 - 0.5 * (f64) view->width) * view->scale;
+    f64 dc_y = ((f64) y + 0.5 - 0.5 * (f64) view->height) * view->scale;
+    *rebased = false;
+    *rejected = self->orbit_length > 1 &&
+                kernel_interior(self->orbit[1].x + dc_x, self->orbit[1].y + dc_y, KERNEL_INTERIOR_MARGIN);
+    if (*rejected) {
+        return view->max_iterations;
+    }
+    return perturb_pixel(self, dc_x, dc_y, view->max_iterations, rebased);
+}
+
+static void perturb_render_tile(void *user, u32 tile, u32 worker) {
+    perturb_job_t *job = user;
+    const fractal_view_t *view = job->view;
+    u32 x0 = (tile % job->tiles_x) * PERTURB_TILE;
+    u32 y0 = (tile / job->tiles_x) * PERTURB_TILE;
+    u32 x1 = x0 + PERTURB_TILE < view->width ? x0 + PERTURB_TILE : view->width;
+    u32 y1 = y0 + PERTURB_TILE < view->height ? y0 + PERTURB_TILE : view->height;
+    u32 rebased = 0;
+    u32 rejected = 0;
+    for (u32 y = y0; y < y1; y++) {
+        for (u32 x = x0; x < x1; x++) {
+            bool pixel_rebased, pixel_rejected;
+            job->iterations[y * view->width + x] = perturb_evaluate(job->perturb, view, x, y, &pixel_rebased,
+                                                                    &pixel_rejected);
+            rebased += pixel_rebased;
+            rejected += pixel_rejected;
+        }
+    }
+    atomic_fetch_add(&job->rebased, rebased);
+    atomic_fetch_add(&job->rejected, rejected);
+}
+
+void perturb_prepare(perturb_t *self, const fractal_view_t *view) {
+    // Enough limbs to resolve the pixel spacing with guard bits to spare
+    f64 bits = -log2(view->scale) + PERTURB_GUARD_BITS;
+    u32 limb_count = (u32) fmin(FIXED_MAX_LIMBS, fmax(2.0, ceil(bits / 32.0) + 1.0));
+    if (!self->orbit_valid || limb_count > self->limb_count || view->max_iterations != self->orbit_iterations) {
+        self->limb_count = limb_count;
+        perturb_orbit_compute(self, view->max_iterations);
+        self->bla_valid = false;
+    }
+    perturb_series_compute(self, view);
+    if (self->bla && (!self->bla_valid || self->bla_radius != self->series_radius)) {
+        perturb_bla_compute(self);
+    }
+}
+
+void perturb_render(perturb_t *self, thread_pool_t *pool, const fractal_view_t *view, u32 *iterations) {
+    perturb_prepare(self, view);
+
+    perturb_job_t job;
+    job.perturb = self;
+    job.view = view;
+    job.iterations = iterations;
+    job.tiles_x = (view->width + PERTURB_TILE - 1) / PERTURB_TILE;
+    atomic_init(&job.rebased, 0);
+    atomic_init(&job.rejected, 0);
+    u32 tiles = job.tiles_x * ((view->height + PERTURB_TILE - 1) / PERTURB_TILE);
+    if (pool) {
+        thread_pool_run(pool, tiles, perturb_render_tile, &job);
+    } else {
+        for (u32 tile = 0; tile < tiles; tile++) {
+            perturb_render_tile(&job, tile, 0);
+        }
+    }
+    self->rebased = atomic_load(&job.rebased);
+    self->stats.rejected = atomic_load(&job.rejected);
+}
+
+void perturb_render_pixels(const perturb_t *self, const fractal_view_t *view, const u32 *pixels, u32 count,
+                           u32 *iterations, kernel_stats_t *stats) {
+    for (u32 i = 0; i < count; i++) {
+        bool rebased, rejected;
+        iterations[pixels[i]] = perturb_evaluate(self, view, pixels[i] % view->width, pixels[i] / view->width,
+                                                 &rebased, &rejected);
+        stats->rejected += rejected;
+    }
+}
@@ -0,0 +1,171 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_PERTURB_H
+#define LIBFRACTAL_PERTURB_H
+
+#include "fixed.h"
+#include "kernel.h"
+#include "thread.h"
+#include "types.h"
+#include "view.h"
+
+// Terms of the series approximation
+#define PERTURB_SERIES_TERMS 8
+
+// Levels of the bilinear approximation table, level k skips 2^k iterations
+#define PERTURB_BLA_LEVELS 32
+
+/**
+ * Bilinear approximation dz_{m+l} = a dz_m + b dc of l iterations starting at
+ * reference iteration m, valid while |dz_m| < radius
+ */
+typedef struct perturb_bla {
+    f64vec2_t a;
+    f64vec2_t b;
+    f64 radius;
+} perturb_bla_t;
+
+/**
+ * Perturbation renderer for views beyond double-double precision. A single reference
+ * orbit is iterated at the center in high precision, every pixel then only iterates
+ * its offset from the reference in double precision. With the series approximation
+ * enabled, the first series_skip iterations are replaced by evaluating a polynomial
+ * in the pixel offset for all pixels at once. The bilinear approximation table then
+ * lets pixels jump over whole blocks of reference iterations while their offset
+ * stays small, anywhere along the orbit. Pixels whose offset outgrows the reference
+ * are rebased onto the start of the reference orbit instead of glitching.
+ */
+typedef struct perturb {
+    fixed_t center_x;
+    fixed_t center_y;
+    u32 limb_count;
+    f64vec2_t *orbit;
+    u32 orbit_length;
+    u32 orbit_capacity;
+    u32 orbit_iterations;
+    bool orbit_valid;
+    bool series;
+    f64vec2_t series_coefficients[PERTURB_SERIES_TERMS];
+    f64 series_radius;
+    u32 series_skip;
+    bool bla;
+    perturb_bla_t *bla_table;
+    u32 bla_capacity;
+    u32 bla_levels;
+    u32 bla_offsets[PERTURB_BLA_LEVELS];
+    u32 bla_counts[PERTURB_BLA_LEVELS];
+    f64 bla_radius;
+    bool bla_valid;
+    u32 rebased;
+    kernel_stats_t stats;
+} perturb_t;
+
+/**
+ * Creates a perturbation renderer centered at the origin with the series approximation
+ * and the bilinear approximation enabled
+ *
+ * @param self perturbation handle
+ */
+void perturb_create(perturb_t *self);
+
+/**
+ * Destroys the perturbation renderer
+ *
+ * @param self perturbation handle
+ */
+void perturb_destroy(perturb_t *self);
+
+/**
+ * Sets the center from decimal strings such as "-0.7436438870371587047521915",
+ * the center of the view is ignored by perturb_render
+ *
+ * @param self perturbation handle
+ * @param x real part
+ * @param y imaginary part
+ * @return false if one of the strings is not a decimal number
+ */
+bool perturb_center(perturb_t *self, const char *x, const char *y);
+
+/**
+ * Sets the center to the double-double center of the view
+ *
+ * @param self perturbation handle
+ * @param view view handle
+ */
+void perturb_center_view(perturb_t *self, const fractal_view_t *view);
+
+/**
+ * Enables or disables the series approximation
+ *
+ * @param self perturbation handle
+ * @param enabled bool
+ */
+void perturb_series(perturb_t *self, bool enabled);
+
+/**
+ * Enables or disables the bilinear approximation
+ *
+ * @param self perturbation handle
+ * @param enabled bool
+ */
+void perturb_bla(perturb_t *self, bool enabled);
+
+/**
+ * Computes the reference orbit and the approximations for the view the way perturb_render
+ * does, afterwards perturb_render_pixels may be called from any number of threads
+ *
+ * @param self perturbation handle
+ * @param view view handle, only size, scale and max_iterations are used
+ */
+void perturb_prepare(perturb_t *self, const fractal_view_t *view);
+
+/**
+ * Renders the view around the center of the perturbation renderer, the reference orbit
+ * is only recomputed when center, precision or iteration limit changed. The number of
+ * iterations skipped by the series approximation is left in series_skip, the number
+ * of pixels that had to be rebased in rebased and the counters of the frame in stats.
+ *
+ * @param self perturbation handle
+ * @param pool pool handle, NULL renders on the calling thread
+ * @param view view handle, only size, scale and max_iterations are used
+ * @param iterations iteration count per pixel, see fractal_cpu_render
+ */
+void perturb_render(perturb_t *self, thread_pool_t *pool, const fractal_view_t *view, u32 *iterations);
+
+/**
+ * Evaluates only the specified pixels of the view, see fractal_cpu_render_pixels. The
+ * renderer has to be prepared for the view with perturb_prepare first.
+ *
+ * @param self perturbation handle
+ * @param view view handle, only size, scale and max_iterations are used
+ * @param pixels pixel indices (y * width + x)
+ * @param count number of pixels
+ * @param iterations iteration count per pixel of the whole view, only the specified pixels are written
+ * @param stats counters that are incremented
+ */
+void perturb_render_pixels(const perturb_t *self, const fractal_view_t *view, const u32 *pixels, u32 count,
+                           u32 *iterations, kernel_stats_t *stats);
+
+#endif// LIBFRACTAL_PERTURB_H
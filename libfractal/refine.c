@@ -0,0 +1,487 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "cpu.h"
+#include "math.h"
+#include "refine.h"
+
+// Pixels of a row that are gathered before they are handed to the kernel
+#define REFINE_BATCH 256
+
+typedef struct refine_job {
+    refine_t *refine;
+    const kernel_t *kernel;
+    fractal_precision_t precision;
+    u32 stride;
+    u32 previous;
+    u32 known_x0;
+    u32 known_y0;
+    u32 known_x1;
+    u32 known_y1;
+    u32 limit;
+    atomic_uint rejected;
+    atomic_uint periodic;
+    atomic_uint attracted;
+} refine_job_t;
+
+void refine_create(refine_t *self) {
+    self->iterations = NULL;
+    self->values = NULL;
+    self->capacity = 0;
+    self->level = REFINE_LEVELS;
+    self->method = REFINE_METHOD_LEVELS;
+    self->stats = (kernel_stats_t) {0};
+    perturb_create(&self->perturb);
+}
+
+void refine_destroy(refine_t *self) {
+    free(self->iterations);
+    free(self->values);
+    self->iterations = NULL;
+    self->values = NULL;
+    self->capacity = 0;
+    perturb_destroy(&self->perturb);
+}
+
+u32 refine_stride(u32 level) {
+    static const u32 strides[REFINE_LEVELS] = {16, 4, 2, 1};
+    return strides[level];
+}
+
+void refine_reset(refine_t *self, const fractal_view_t *view) {
+    u32 size = view->width * view->height;
+    if (size > self->capacity) {
+        u32 *iterations = realloc(self->iterations, size * sizeof(u32));
+        f32 *values = realloc(self->values, size * sizeof(f32));
+        ASSERT(iterations && values, "[refine] failed to allocate buffers of %u pixels\n", size);
+        self->iterations = iterations;
+        self->values = values;
+        self->capacity = size;
+    }
+    self->view = *view;
+    self->level = 0;
+    self->stats = (kernel_stats_t) {0};
+}
+
+static void refine_job_init(refine_t *self, refine_job_t *job) {
+    // The reference orbit is computed once up front, the workers only read it
+    job->refine = self;
+    job->kernel = kernel_select();
+    job->precision = fractal_view_precision(&self->view);
+    if (job->precision == FRACTAL_PRECISION_PERTURBATION) {
+        perturb_center_view(&self->perturb, &self->view);
+        perturb_prepare(&self->perturb, &self->view);
+    }
+    atomic_init(&job->rejected, 0);
+    atomic_init(&job->periodic, 0);
+    atomic_init(&job->attracted, 0);
+}
+
+static void refine_render_pixels(refine_job_t *job, const u32 *pixels, u32 count, kernel_stats_t *stats) {
+    refine_t *refine = job->refine;
+    if (job->precision == FRACTAL_PRECISION_PERTURBATION) {
+        perturb_render_pixels(&refine->perturb, &refine->view, pixels, count, refine->iterations, stats);
+    } else {
+        fractal_cpu_render_pixels(&refine->view, job->kernel, job->precision, pixels, count, refine->iterations,
+                                  stats);
+    }
+}
+
+static void refine_row(void *user, u32 row, u32 worker) {
+    refine_job_t *job = user;
+    refine_t *refine = job->refine;
+    const fractal_view_t *view = &refine->view;
+    u32 stride = job->stride;
+    u32 y = row * stride;
+
+    // Samples that lie on the lattice of the previous level are known already
+    bool known = job->previous && y % job->previous == 0;
+    u32 pixels[REFINE_BATCH];
+    u32 count = 0;
+    kernel_stats_t stats = {0};
+    for (u32 x = 0; x < view->width; x += stride) {
+        if (known && x % job->previous == 0) {
+            continue;
+        }
+        pixels[count++] = y * view->width + x;
+        if (count == REFINE_BATCH) {
+            refine_render_pixels(job, pixels, count, &stats);
+            count = 0;
+        }
+    }
+    refine_render_pixels(job, pixels, count, &stats);
+
+    // The block below each sample shows the sample until a finer level replaces it
+    u32 y1 = (u32) s32_min((s32) (y + stride), (s32) view->height);
+    const u32 *samples = refine->iterations + y * view->width;
+    for (u32 block_y = y; block_y < y1; block_y++) {
+        u32 *target = refine->iterations + block_y * view->width;
+        f32 *values = refine->values + block_y * view->width;
+        for (u32 x = 0; x < view->width; x++) {
+            target[x] = samples[x - x % stride];
+            values[x] = fractal_cpu_value(target[x], view->max_iterations);
+        }
+    }
+    atomic_fetch_add(&job->rejected, stats.rejected);
+    atomic_fetch_add(&job->periodic, stats.periodic);
+    atomic_fetch_add(&job->attracted, stats.attracted);
+}
+
+void refine_method(refine_t *self, refine_method_t method) {
+    self->method = method;
+}
+
+static void refine_whole(refine_t *self, thread_pool_t *pool) {
+    // Samples of earlier levels are evaluated again, the method has no use for them
+    kernel_stats_t stats = {0};
+    if (self->method == REFINE_METHOD_TRACE) {
+        trace_render(pool, &self->perturb, &self->view, self->iterations, NULL, &stats);
+    } else {
+        subdivide_render(pool, &self->perturb, &self->view, self->iterations, NULL, &stats);
+    }
+    u32 size = self->view.width * self->view.height;
+    for (u32 i = 0; i < size; i++) {
+        self->values[i] = fractal_cpu_value(self->iterations[i], self->view.max_iterations);
+    }
+    self->stats.rejected += stats.rejected;
+    self->stats.periodic += stats.periodic;
+    self->stats.attracted += stats.attracted;
+    self->stats.filled += stats.filled;
+    self->level = REFINE_LEVELS;
+}
+
+bool refine_step(refine_t *self, thread_pool_t *pool) {
+    if (refine_complete(self)) {
+        return false;
+    }
+    if (self->method != REFINE_METHOD_LEVELS) {
+        refine_whole(self, pool);
+        return true;
+    }
+
+    refine_job_t job;
+    refine_job_init(self, &job);
+    job.stride = refine_stride(self->level);
+    job.previous = self->level > 0 ? refine_stride(self->level - 1) : 0;
+    u32 rows = (self->view.height + job.stride - 1) / job.stride;
+    if (pool) {
+        thread_pool_run(pool, rows, refine_row, &job);
+    } else {
+        for (u32 row = 0; row < rows; row++) {
+            refine_row(&job, row, 0);
+        }
+    }
+    self->stats.rejected += atomic_load(&job.rejected);
+    self->stats.periodic += atomic_load(&job.periodic);
+    self->stats.attracted += atomic_load(&job.attracted);
+    self->level++;
+    return true;
+}
+
+static void refine_evaluate(refine_job_t *job, u32 y, u32 x0, u32 x1, kernel_stats_t *stats) {
+    refine_t *refine = job->refine;
+    const fractal_view_t *view = &refine->view;
+    u32 pixels[REFINE_BATCH];
+    u32 count = 0;
+    for (u32 x = x0; x < x1; x++) {
+        pixels[count++] = y * view->width + x;
+        if (count == REFINE_BATCH || x + 1 == x1) {
+            refine_render_pixels(job, pixels, count, stats);
+            count = 0;
+        }
+    }
+
+    u32 *iterations = refine->iterations + y * view->width;
+    f32 *values = refine->values + y * view->width;
+    for (u32 x = x0; x < x1; x++) {
+        values[x] = fractal_cpu_value(iterations[x], view->max_iterations);
+    }
+}
+
+static void refine_exposed(void *user, u32 y, u32 worker) {
+    // Everything outside the known rectangle is evaluated
+    refine_job_t *job = user;
+    u32 width = job->refine->view.width;
+    kernel_stats_t stats = {0};
+    if (y >= job->known_y0 && y < job->known_y1) {
+        refine_evaluate(job, y, 0, job->known_x0, &stats);
+        refine_evaluate(job, y, job->known_x1, width, &stats);
+    } else {
+        refine_evaluate(job, y, 0, width, &stats);
+    }
+    atomic_fetch_add(&job->rejected, stats.rejected);
+    atomic_fetch_add(&job->periodic, stats.periodic);
+    atomic_fetch_add(&job->attracted, stats.attracted);
+}
+
+static void refine_expose(refine_t *self, thread_pool_t *pool, u32 x0, u32 y0, u32 x1, u32 y1) {
+    refine_job_t job;
+    refine_job_init(self, &job);
+    job.known_x0 = x0;
+    job.known_y0 = y0;
+    job.known_x1 = x1;
+    job.known_y1 = y1;
+    if (pool) {
+        thread_pool_run(pool, self->view.height, refine_exposed, &job);
+    } else {
+        for (u32 y = 0; y < self->view.height; y++) {
+            refine_exposed(&job, y, 0);
+        }
+    }
+    self->stats.rejected += atomic_load(&job.rejected);
+    self->stats.periodic += atomic_load(&job.periodic);
+    self->stats.attracted += atomic_load(&job.attracted);
+}
+
+static void refine_limited(void *user, u32 y, u32 worker) {
+    refine_job_t *job = user;
+    refine_t *refine = job->refine;
+    const fractal_view_t *view = &refine->view;
+    u32 *iterations = refine->iterations + y * view->width;
+    f32 *values = refine->values + y * view->width;
+
+    // Samples that reached the previous limit are evaluated again if the limit was raised,
+    // lowering it only clamps them. Every value depends on the limit
+    u32 pixels[REFINE_BATCH];
+    u32 count = 0;
+    kernel_stats_t stats = {0};
+    for (u32 x = 0; x < view->width; x++) {
+        if (iterations[x] >= job->limit && view->max_iterations > job->limit) {
+            pixels[count++] = y * view->width + x;
+        }
+        if (count > 0 && (count == REFINE_BATCH || x + 1 == view->width)) {
+            refine_render_pixels(job, pixels, count, &stats);
+            count = 0;
+        }
+    }
+    for (u32 x = 0; x < view->width; x++) {
+        iterations[x] = (u32) s32_min((s32) iterations[x], (s32) view->max_iterations);
+        values[x] = fractal_cpu_value(iterations[x], view->max_iterations);
+    }
+    atomic_fetch_add(&job->rejected, stats.rejected);
+    atomic_fetch_add(&job->periodic, stats.periodic);
+    atomic_fetch_add(&job->attracted, stats.attracted);
+}
+
+static void refine_limit(refine_t *self, thread_pool_t *pool, u32 max_iterations) {
+    if (self->view.max_iterations == max_iterations) {
+        return;
+    }
+
+    // The reference orbit has to reach the new limit
+    u32 limit = self->view.max_iterations;
+    self->view.max_iterations = max_iterations;
+    refine_job_t job;
+    refine_job_init(self, &job);
+    job.limit = limit;
+    if (pool) {
+        thread_pool_run(pool, self->view.height, refine_limited, &job);
+    } else {
+        for (u32 y = 0; y < self->view.height; y++) {
+            refine_limited(&job, y, 0);
+        }
+    }
+    self->stats.rejected += atomic_load(&job.rejected);
+    self->stats.periodic += atomic_load(&job.periodic);
+    self->stats.attracted += atomic_load(&job.attracted);
+}
+
+static void refine_shift(refine_t *self, s32 offset_x, s32 offset_y) {
+    // Rows are visited in the order that reads every source row before it is overwritten,
+    // memmove takes care of the overlap within a row
+    u32 width = self->view.width;
+    u32 height = self->view.height;
+    u32 columns = width - (u32) abs(offset_x);
+    u32 source_x = (u32) s32_max(offset_x, 0);
+    u32 target_x = (u32) s32_max(-offset_x, 0);
+    for (u32 i = 0; i < height - (u32) abs(offset_y); i++) {
+        u32 y = offset_y >= 0 ? i : height - 1 - i;
+        u32 target = y * width + target_x;
+        u32 source = (u32) ((s32) y + offset_y) * width + source_x;
+        memmove(self->iterations + target, self->iterations + source, columns * sizeof(u32));
+        memmove(self->values + target, self->values + source, columns * sizeof(f32));
+    }
+}
+
+static bool refine_reusable(const refine_t *self, const fractal_view_t *view, s32 *offset_x, s32 *offset_y) {
+    // The iteration limit is brought in line by refine_limit, samples of a different precision
+    // would show a seam along the evaluated pixels though
+    if (self->iterations == NULL || !refine_complete(self)) {
+        return false;
+    }
+    fractal_view_t limited = self->view;
+    limited.max_iterations = view->max_iterations;
+    return fractal_view_offset(&limited, view, offset_x, offset_y) &&
+           fractal_view_precision(&limited) == fractal_view_precision(view);
+}
+
+bool refine_translate(refine_t *self, thread_pool_t *pool, const fractal_view_t *view) {
+    s32 offset_x, offset_y;
+    if (view->scale != self->view.scale || !refine_reusable(self, view, &offset_x, &offset_y) ||
+        abs(offset_x) > (s32) view->width || abs(offset_y) > (s32) view->height) {
+        return false;
+    }
+    self->stats = (kernel_stats_t) {0};
+    refine_limit(self, pool, view->max_iterations);
+    refine_shift(self, offset_x, offset_y);
+    self->view = *view;
+
+    // Pixel x shows pixel x + offset_x of the previous view
+    refine_expose(self, pool, (u32) s32_max(-offset_x, 0), (u32) s32_max(-offset_y, 0),
+                  (u32) s32_min((s32) view->width - offset_x, (s32) view->width),
+                  (u32) s32_min((s32) view->height - offset_y, (s32) view->height));
+    return true;
+}
+
+static void refine_zoom_in(refine_t *self, const u32 *samples, s32 offset_x, s32 offset_y) {
+    // Pixel 2x of the view is pixel x + offset of the previous one, the odd pixels show the
+    // sample to their lower left until the last level evaluates them
+    const fractal_view_t *view = &self->view;
+    for (u32 y = 0; y < view->height; y++) {
+        const u32 *source = samples + (y / 2 + (u32) offset_y) * view->width + (u32) offset_x;
+        u32 *iterations = self->iterations + y * view->width;
+        f32 *values = self->values + y * view->width;
+        for (u32 x = 0; x < view->width; x++) {
+            iterations[x] = source[x / 2];
+            values[x] = fractal_cpu_value(iterations[x], view->max_iterations);
+        }
+    }
+    self->level = REFINE_LEVELS - 1;
+}
+
+static void refine_zoom_out(refine_t *self, thread_pool_t *pool, const u32 *samples, s32 offset_x, s32 offset_y) {
+    // Pixel x of the view is pixel 2x + offset of the previous one, the ring around the
+    // previous view is evaluated right away
+    const fractal_view_t *view = &self->view;
+    s32 x0 = offset_x >= 0 ? 0 : (1 - offset_x) / 2;
+    s32 y0 = offset_y >= 0 ? 0 : (1 - offset_y) / 2;
+    s32 x1 = s32_min(((s32) view->width - 1 - offset_x) / 2 + 1, (s32) view->width);
+    s32 y1 = s32_min(((s32) view->height - 1 - offset_y) / 2 + 1, (s32) view->height);
+    for (s32 y = y0; y < y1; y++) {
+        const u32 *source = samples + (u32) (2 * y + offset_y) * view->width;
+        u32 *iterations = self->iterations + (u32) y * view->width;
+        f32 *values = self->values + (u32) y * view->width;
+        for (s32 x = x0; x < x1; x++) {
+            iterations[x] = source[2 * x + offset_x];
+            values[x] = fractal_cpu_value(iterations[x], view->max_iterations);
+        }
+    }
+    refine_expose(self, pool, (u32) x0, (u32) y0, (u32) x1, (u32) y1);
+}
+
+bool refine_zoom(refine_t *self, thread_pool_t *pool, const fractal_view_t *view) {
+    s32 offset_x, offset_y;
+    f64 ratio = view->scale / self->view.scale;
+    if ((ratio != 0.5 && ratio != 2.0) || !refine_reusable(self, view, &offset_x, &offset_y)) {
+        return false;
+    }
+
+    // Zooming in needs a sample for every even pixel, zooming out at least one sample
+    s32 last_x = ((s32) view->width - 1) / 2 + offset_x;
+    s32 last_y = ((s32) view->height - 1) / 2 + offset_y;
+    if (ratio == 0.5 && (offset_x < 0 || offset_y < 0 || last_x >= (s32) view->width ||
+                         last_y >= (s32) view->height)) {
+        return false;
+    }
+    if (ratio == 2.0 && (offset_x <= -2 * (s32) view->width || offset_x >= (s32) view->width ||
+                         offset_y <= -2 * (s32) view->height || offset_y >= (s32) view->height)) {
+        return false;
+    }
+
+    self->stats = (kernel_stats_t) {0};
+    refine_limit(self, pool, view->max_iterations);
+
+    // The samples are moved through a copy, source and target overlap in both directions
+    u32 size = view->width * view->height;
+    u32 *samples = malloc(size * sizeof(u32));
+    ASSERT(samples, "[refine] failed to allocate a copy of %u samples\n", size);
+    memcpy(samples, self->iterations, size * sizeof(u32));
+    self->view = *view;
+    if (ratio == 0.5) {
+        refine_zoom_in(self, samples, offset_x, offset_y);
+    } else {
+        refine_zoom_out(self, pool, samples, offset_x, offset_y);
+    }
+    free(samples);
+    return true;
+}
+
+static void refine_unknown(void *user, u32 y, u32 worker) {
+    // Pixels the cache did not know are evaluated, every value is updated
+    refine_job_t *job = user;
+    refine_t *refine = job->refine;
+    const fractal_view_t *view = &refine->view;
+    u32 *iterations = refine->iterations + y * view->width;
+    f32 *values = refine->values + y * view->width;
+    u32 pixels[REFINE_BATCH];
+    u32 count = 0;
+    kernel_stats_t stats = {0};
+    for (u32 x = 0; x < view->width; x++) {
+        if (iterations[x] == CACHE_UNKNOWN) {
+            pixels[count++] = y * view->width + x;
+        }
+        if (count > 0 && (count == REFINE_BATCH || x + 1 == view->width)) {
+            refine_render_pixels(job, pixels, count, &stats);
+            count = 0;
+        }
+    }
+    for (u32 x = 0; x < view->width; x++) {
+        values[x] = fractal_cpu_value(iterations[x], view->max_iterations);
+    }
+    atomic_fetch_add(&job->rejected, stats.rejected);
+    atomic_fetch_add(&job->periodic, stats.periodic);
+    atomic_fetch_add(&job->attracted, stats.attracted);
+}
+
+bool refine_load(refine_t *self, thread_pool_t *pool, cache_t *cache) {
+    // Mostly unknown views are left to the levels, which show a preview much sooner
+    u32 size = self->view.width * self->view.height;
+    if (refine_complete(self) || cache_load(cache, &self->view, self->iterations) < size - size / 2) {
+        return false;
+    }
+
+    refine_job_t job;
+    refine_job_init(self, &job);
+    if (pool) {
+        thread_pool_run(pool, self->view.height, refine_unknown, &job);
+    } else {
+        for (u32 y = 0; y < self->view.height; y++) {
+            refine_unknown(&job, y, 0);
+        }
+    }
+    self->stats.rejected += atomic_load(&job.rejected);
+    self->stats.periodic += atomic_load(&job.periodic);
+    self->stats.attracted += atomic_load(&job.attracted);
+    self->level = REFINE_LEVELS;
+    return true;
+}
+
+bool refine_complete(const refine_t *self) {
+    return self->level >= REFINE_LEVELS;
+}
@@ -0,0 +1,165 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_REFINE_H
+#define LIBFRACTAL_REFINE_H
+
+#include "cache.h"
+#include "kernel.h"
+#include "perturb.h"
+#include "subdivide.h"
+#include "thread.h"
+#include "trace.h"
+#include "types.h"
+#include "view.h"
+
+/**
+ * Number of refinement levels, see refine_stride
+ */
+#define REFINE_LEVELS 4
+
+/**
+ * How refine_step evaluates a view, the levels show a coarse preview right away. Subdivision
+ * and boundary tracing complete the view in a single step instead, see subdivide_render and
+ * trace_render.
+ */
+typedef enum refine_method {
+    REFINE_METHOD_LEVELS = 0, REFINE_METHOD_SUBDIVIDE, REFINE_METHOD_TRACE
+} refine_method_t;
+
+/**
+ * Successive refinement of a view. The first level samples every 16th pixel, the following
+ * ones every 4th, every 2nd and finally every pixel. Samples of a coarser level are part of
+ * every finer lattice and are never evaluated again, so all levels together cost a single
+ * full resolution pass. Pixels that are not sampled yet show the sample of their block.
+ * Values are the iterations as the color pass expects them, see fractal_cpu_value. Perturbation
+ * views keep their reference orbit for as long as the center does not move.
+ */
+typedef struct refine {
+    fractal_view_t view;
+    u32 *iterations;
+    f32 *values;
+    u32 capacity;
+    u32 level;
+    refine_method_t method;
+    kernel_stats_t stats;
+    perturb_t perturb;
+} refine_t;
+
+/**
+ * Creates a new refinement without any view that evaluates views level by level
+ *
+ * @param self refine handle
+ */
+void refine_create(refine_t *self);
+
+/**
+ * Releases the buffers of the refinement
+ *
+ * @param self refine handle
+ */
+void refine_destroy(refine_t *self);
+
+/**
+ * Returns the distance between two samples of the specified level
+ *
+ * @param level refinement level
+ * @return stride in pixels
+ */
+u32 refine_stride(u32 level);
+
+/**
+ * Starts over with the specified view, nothing is evaluated until the next refine_step
+ *
+ * @param self refine handle
+ * @param view view handle
+ */
+void refine_reset(refine_t *self, const fractal_view_t *view);
+
+/**
+ * Selects how refine_step evaluates the views from now on, a pending view continues
+ * with the new method
+ *
+ * @param self refine handle
+ * @param method refine method
+ */
+void refine_method(refine_t *self, refine_method_t method);
+
+/**
+ * Evaluates the next level, afterwards iterations and values hold the complete image at that level.
+ * Methods other than the levels complete the view in one step.
+ *
+ * @param self refine handle
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @return false if the view was already complete
+ */
+bool refine_step(refine_t *self, thread_pool_t *pool);
+
+/**
+ * Moves a complete refinement to a view that is panned by whole pixels, the samples that stay
+ * on screen are kept and only the exposed rows and columns are evaluated. The stats only count
+ * the evaluated pixels then. A changed iteration limit clamps the samples if it was lowered,
+ * if it was raised the samples that reached the previous limit are evaluated again.
+ *
+ * @param self refine handle
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @param view view handle
+ * @return false if nothing can be reused, the refinement is left untouched then
+ */
+bool refine_translate(refine_t *self, thread_pool_t *pool, const fractal_view_t *view);
+
+/**
+ * Moves a complete refinement to a view that is zoomed by a factor of two with aligned pixel
+ * lattices, see fractal_view_zoom_aligned. Zooming in upsamples the previous samples as a
+ * preview and leaves the last level to evaluate the three quarters in between. Zooming out keeps
+ * every other sample and evaluates the ring around them right away. The iteration limit is
+ * handled as with refine_translate.
+ *
+ * @param self refine handle
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @param view view handle
+ * @return false if nothing can be reused, the refinement is left untouched then
+ */
+bool refine_zoom(refine_t *self, thread_pool_t *pool, const fractal_view_t *view);
+
+/**
+ * Completes a refinement that was just reset from the cached tiles if they hold at least half
+ * of its pixels, the remaining pixels are evaluated right away. The stats only count those.
+ *
+ * @param self refine handle
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @param cache cache handle
+ * @return false if the cache knows too little, the levels start over then
+ */
+bool refine_load(refine_t *self, thread_pool_t *pool, cache_t *cache);
+
+/**
+ * Checks whether every pixel of the view was evaluated
+ *
+ * @param self refine handle
+ * @return bool
+ */
+bool refine_complete(const refine_t *self);
+
+#endif// LIBFRACTAL_REFINE_H
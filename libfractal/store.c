@@ -0,0 +1,498 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "store.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Identifies segment files, "tils" in little endian
+#define STORE_MAGIC 0x736c6974u
+
+// Index of neither a segment nor an entry
+#define STORE_NONE 0xffffffffu
+
+#define STORE_TILE_BYTES (CACHE_TILE_SIZE * CACHE_TILE_SIZE * sizeof(u32))
+#define STORE_TILES_OFFSET                                                                                             \
+    ((sizeof(store_header_t) + STORE_SEGMENT_TILES * sizeof(store_record_t) + 4095) & ~(u64) 4095)
+#define STORE_SEGMENT_BYTES (STORE_TILES_OFFSET + STORE_SEGMENT_TILES * STORE_TILE_BYTES)
+
+// Room for the name of a segment file behind the directory, "/segment-4294967295.tiles"
+#define STORE_NAME_LENGTH 32
+
+// Segments that are being created by another process are skipped for this long at most
+#define STORE_CREATE_ATTEMPTS 64
+
+// ===================================================================================
+// PLATFORM
+// ===================================================================================
+
+static bool store_directory_create(const char *path) {
+#ifdef _WIN32
+    return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+static u32 store_directory_list(const char *path, u32 **result) {
+    // Numbers of all segment files in the directory, unsorted
+    u32 *numbers = NULL;
+    u32 count = 0;
+    u32 capacity = 0;
+#ifdef _WIN32
+    char pattern[STORE_PATH_LENGTH + STORE_NAME_LENGTH];
+    snprintf(pattern, sizeof pattern, "%s\\segment-*.tiles", path);
+    WIN32_FIND_DATAA entry;
+    HANDLE directory = FindFirstFileA(pattern, &entry);
+    if (directory == INVALID_HANDLE_VALUE) {
+        *result = NULL;
+        return 0;
+    }
+    do {
+        const char *name = entry.cFileName;
+#else
+    DIR *directory = opendir(path);
+    if (directory == NULL) {
+        *result = NULL;
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL) {
+        const char *name = entry->d_name;
+#endif
+        u32 number;
+        char suffix[8];
+        if (sscanf(name, "segment-%u.%7s", &number, suffix) != 2 || strcmp(suffix, "tiles") != 0) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            u32 *grown = realloc(numbers, capacity * sizeof(u32));
+            ASSERT(grown, "[store] failed to list %u segments\n", capacity);
+            numbers = grown;
+        }
+        numbers[count++] = number;
+#ifdef _WIN32
+    } while (FindNextFileA(directory, &entry));
+    FindClose(directory);
+#else
+    }
+    closedir(directory);
+#endif
+    *result = numbers;
+    return count;
+}
+
+static void store_segment_path(const store_t *self, u32 number, char *result) {
+#ifdef _WIN32
+    snprintf(result, STORE_PATH_LENGTH + STORE_NAME_LENGTH, "%s\\segment-%08u.tiles", self->path, number);
+#else
+    snprintf(result, STORE_PATH_LENGTH + STORE_NAME_LENGTH, "%s/segment-%08u.tiles", self->path, number);
+#endif
+}
+
+static bool store_segment_map(const store_t *self, store_segment_t *segment, bool create) {
+    // Created segments are mapped for writing, the file itself is not needed once mapped
+    char path[STORE_PATH_LENGTH + STORE_NAME_LENGTH];
+    store_segment_path(self, segment->number, path);
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, create ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              create ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!create && (!GetFileSizeEx(file, &size) || (u64) size.QuadPart < STORE_SEGMENT_BYTES)) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, create ? PAGE_READWRITE : PAGE_READONLY,
+                                        (DWORD) (STORE_SEGMENT_BYTES >> 32), (DWORD) STORE_SEGMENT_BYTES, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return false;
+    }
+    segment->data = MapViewOfFile(mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, STORE_SEGMENT_BYTES);
+    CloseHandle(mapping);
+    if (segment->data == NULL) {
+        return false;
+    }
+#else
+    int file = open(path, create ? O_RDWR | O_CREAT | O_EXCL : O_RDONLY, 0644);
+    if (file < 0) {
+        return false;
+    }
+    struct stat info;
+    if (create ? ftruncate(file, (off_t) STORE_SEGMENT_BYTES) != 0
+               : fstat(file, &info) != 0 || (u64) info.st_size < STORE_SEGMENT_BYTES) {
+        close(file);
+        return false;
+    }
+    void *data = mmap(NULL, STORE_SEGMENT_BYTES, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    segment->data = data;
+#endif
+    segment->owned = create;
+    return true;
+}
+
+static void store_segment_unmap(store_segment_t *segment) {
+#ifdef _WIN32
+    UnmapViewOfFile(segment->data);
+#else
+    munmap(segment->data, STORE_SEGMENT_BYTES);
+#endif
+    segment->data = NULL;
+}
+
+static void store_segment_delete(const store_t *self, u32 number) {
+    // Processes that still map the segment keep their view of it
+    char path[STORE_PATH_LENGTH + STORE_NAME_LENGTH];
+    store_segment_path(self, number, path);
+#ifdef _WIN32
+    DeleteFileA(path);
+#else
+    unlink(path);
+#endif
+}
+
+// ===================================================================================
+// INDEX
+// ===================================================================================
+
+static store_header_t *store_segment_header(const store_segment_t *segment) {
+    return (store_header_t *) segment->data;
+}
+
+static store_record_t *store_segment_record(const store_segment_t *segment, u32 slot) {
+    return (store_record_t *) (segment->data + sizeof(store_header_t)) + slot;
+}
+
+static u32 *store_segment_tile(const store_segment_t *segment, u32 slot) {
+    return (u32 *) (segment->data + STORE_TILES_OFFSET + slot * STORE_TILE_BYTES);
+}
+
+static u32 store_segment_count(const store_segment_t *segment) {
+    // Records are complete before the count includes them, see store_write
+    u32 count = store_segment_header(segment)->count;
+    atomic_thread_fence(memory_order_acquire);
+    return count < STORE_SEGMENT_TILES ? count : STORE_SEGMENT_TILES;
+}
+
+static bool store_record_match(const store_record_t *a, const store_record_t *b) {
+    return a->level == b->level && a->x == b->x && a->y == b->y && a->precision == b->precision &&
+           a->periodicity == b->periodicity && a->attraction == b->attraction;
+}
+
+static u32 store_record_hash(const store_record_t *record) {
+    // splitmix64 finalizer over the identity of the tile
+    u64 hash = (u64) record->x * 0x9e3779b97f4a7c15ull ^ (u64) record->y * 0xc2b2ae3d27d4eb4full ^
+               (u64) record->level ^ (u64) record->precision << 40 ^ (u64) record->periodicity << 48 ^
+               (u64) record->attraction << 56;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return (u32) (hash ^ (hash >> 31));
+}
+
+static u32 store_index_find(const store_t *self, const store_record_t *record) {
+    // Either the entry of the tile or the empty entry where it belongs
+    u32 entry = store_record_hash(record) & self->entry_mask;
+    while (self->entries[entry].segment != STORE_NONE) {
+        const store_entry_t *candidate = self->entries + entry;
+        if (store_record_match(store_segment_record(self->segments + candidate->segment, candidate->slot), record)) {
+            break;
+        }
+        entry = (entry + 1) & self->entry_mask;
+    }
+    return entry;
+}
+
+static void store_index_insert(store_t *self, u32 segment, u32 slot) {
+    // Records of other processes may be indexed after newer ones of this process
+    store_entry_t *entry = self->entries + store_index_find(self, store_segment_record(self->segments + segment, slot));
+    if (entry->segment == STORE_NONE || entry->segment <= segment) {
+        entry->segment = segment;
+        entry->slot = slot;
+    }
+}
+
+static bool store_index_segment(store_t *self, u32 segment) {
+    // Only the records that were appended since the segment was indexed last
+    store_segment_t *mapped = self->segments + segment;
+    u32 count = store_segment_count(mapped);
+    for (u32 slot = mapped->indexed; slot < count; slot++) {
+        store_index_insert(self, segment, slot);
+    }
+    bool grown = count > mapped->indexed;
+    mapped->indexed = count;
+    return grown;
+}
+
+static void store_index_build(store_t *self) {
+    // Segments are visited from the oldest to the newest, so the newest record of a tile wins
+    for (u32 i = 0; i <= self->entry_mask; i++) {
+        self->entries[i].segment = STORE_NONE;
+    }
+    for (u32 segment = 0; segment < self->count; segment++) {
+        self->segments[segment].indexed = 0;
+        store_index_segment(self, segment);
+    }
+}
+
+static bool store_index_refresh(store_t *self) {
+    // Segments of other processes may have grown since, this process indexes its own writes
+    bool grown = false;
+    for (u32 segment = 0; segment < self->count; segment++) {
+        if (!self->segments[segment].owned) {
+            grown |= store_index_segment(self, segment);
+        }
+    }
+    return grown;
+}
+
+// ===================================================================================
+// STORE
+// ===================================================================================
+
+static void store_evict(store_t *self) {
+    store_segment_unmap(self->segments);
+    store_segment_delete(self, self->segments[0].number);
+    memmove(self->segments, self->segments + 1, --self->count * sizeof(store_segment_t));
+}
+
+static s32 store_number_compare(const void *a, const void *b) {
+    u32 x = *(const u32 *) a;
+    u32 y = *(const u32 *) b;
+    return (x > y) - (x < y);
+}
+
+static bool store_segment_open(const store_t *self, u32 number, store_segment_t *segment) {
+    // Segments that are still being created by another process have no header yet
+    segment->number = number;
+    segment->indexed = 0;
+    if (!store_segment_map(self, segment, false)) {
+        return false;
+    }
+    if (store_segment_header(segment)->magic != STORE_MAGIC) {
+        store_segment_unmap(segment);
+        return false;
+    }
+    return true;
+}
+
+static u32 store_scan(store_t *self) {
+    // Other processes add segments to the directory and delete the ones they evict. Segments
+    // are kept in the order of their numbers, which is the order they were created in. The
+    // result counts every segment file that is left, including those that are not mapped
+    u32 *numbers;
+    u32 count = store_directory_list(self->path, &numbers);
+    qsort(numbers, count, sizeof(u32), store_number_compare);
+    u32 kept = 0;
+    for (u32 i = 0; i < self->count; i++) {
+        if (bsearch(&self->segments[i].number, numbers, count, sizeof(u32), store_number_compare)) {
+            self->segments[kept++] = self->segments[i];
+        } else {
+            store_segment_unmap(self->segments + i);
+        }
+    }
+    self->count = kept;
+
+    // Segments of another kernel version are useless, the oldest segment goes once there are
+    // too many, even if it was just found
+    u32 present = count;
+    u32 position = 0;
+    for (u32 i = 0; i < count; i++) {
+        while (position < self->count && self->segments[position].number < numbers[i]) {
+            position++;
+        }
+        store_segment_t segment;
+        if ((position < self->count && self->segments[position].number == numbers[i]) ||
+            !store_segment_open(self, numbers[i], &segment)) {
+            continue;
+        }
+        const store_header_t *header = store_segment_header(&segment);
+        if (header->version != KERNEL_VERSION || header->tile_size != CACHE_TILE_SIZE) {
+            store_segment_unmap(&segment);
+            store_segment_delete(self, numbers[i]);
+            present--;
+            continue;
+        }
+        memmove(self->segments + position + 1, self->segments + position,
+                (self->count - position) * sizeof(store_segment_t));
+        self->segments[position] = segment;
+        if (++self->count > self->limit) {
+            store_evict(self);
+            present--;
+        } else {
+            position++;
+        }
+    }
+    free(numbers);
+    return present;
+}
+
+bool store_open(store_t *self, const char *path, u64 budget) {
+    self->segments = NULL;
+    self->entries = NULL;
+    self->count = 0;
+    if (strlen(path) >= STORE_PATH_LENGTH || !store_directory_create(path)) {
+        fprintf(stderr, "[store] can not use %s as store directory\n", path);
+        return false;
+    }
+    strcpy(self->path, path);
+
+    // The index has room for every record of a full store and is kept at most half full
+    u64 limit = budget / STORE_SEGMENT_BYTES;
+    self->limit = (u32) (limit < 2 ? 2 : limit > 4096 ? 4096 : limit);
+    u32 entries = 2;
+    while (entries < 2 * self->limit * STORE_SEGMENT_TILES) {
+        entries <<= 1;
+    }
+    self->segments = malloc((self->limit + 1) * sizeof(store_segment_t));
+    self->entries = malloc(entries * sizeof(store_entry_t));
+    ASSERT(self->segments && self->entries, "[store] failed to allocate an index of %u entries\n", entries);
+    self->entry_mask = entries - 1;
+
+    store_scan(self);
+    store_index_build(self);
+    return true;
+}
+
+void store_close(store_t *self) {
+    for (u32 i = 0; i < self->count; i++) {
+        store_segment_unmap(self->segments + i);
+    }
+    free(self->segments);
+    free(self->entries);
+    self->segments = NULL;
+    self->entries = NULL;
+    self->count = 0;
+}
+
+const u32 *store_find(store_t *self, const cache_tile_t *tile, u32 *max_iterations) {
+    store_record_t record = {
+            .level = tile->key.level,
+            .max_iterations = 0,
+            .x = tile->key.x,
+            .y = tile->key.y,
+            .precision = tile->precision,
+            .periodicity = tile->periodicity,
+            .attraction = tile->attraction,
+            .padding = {0, 0},
+    };
+    const store_entry_t *entry = self->entries + store_index_find(self, &record);
+    if (entry->segment == STORE_NONE && store_index_refresh(self)) {
+        entry = self->entries + store_index_find(self, &record);
+    }
+    if (entry->segment == STORE_NONE) {
+        return NULL;
+    }
+    const store_segment_t *segment = self->segments + entry->segment;
+    *max_iterations = store_segment_record(segment, entry->slot)->max_iterations;
+    return store_segment_tile(segment, entry->slot);
+}
+
+static bool store_segment_create(store_t *self) {
+    // Numbers taken by another process in the meantime are skipped, segments it created are
+    // picked up first. The budget covers every segment in the directory, also those that
+    // other processes are still creating
+    u32 present = store_scan(self);
+    while (present >= self->limit && self->count > 0) {
+        store_evict(self);
+        present--;
+    }
+    store_index_build(self);
+
+    u32 number = self->count > 0 ? self->segments[self->count - 1].number + 1 : 0;
+    store_segment_t segment;
+    for (u32 attempt = 0; attempt < STORE_CREATE_ATTEMPTS; attempt++) {
+        segment.number = number + attempt;
+        if (store_segment_map(self, &segment, true)) {
+            break;
+        }
+        segment.data = NULL;
+    }
+    if (segment.data == NULL) {
+        fprintf(stderr, "[store] failed to create a segment in %s\n", self->path);
+        return false;
+    }
+
+    store_header_t *header = store_segment_header(&segment);
+    header->magic = STORE_MAGIC;
+    header->version = KERNEL_VERSION;
+    header->tile_size = CACHE_TILE_SIZE;
+    header->count = 0;
+    segment.indexed = 0;
+    self->segments[self->count++] = segment;
+    return true;
+}
+
+void store_write(store_t *self, const cache_tile_t *tile) {
+    const store_segment_t *newest = self->count > 0 ? self->segments + self->count - 1 : NULL;
+    if ((newest == NULL || !newest->owned || store_segment_count(newest) == STORE_SEGMENT_TILES) &&
+        !store_segment_create(self)) {
+        return;
+    }
+
+    // Other processes only read the record once the count includes it
+    u32 index = self->count - 1;
+    store_segment_t *segment = self->segments + index;
+    store_header_t *header = store_segment_header(segment);
+    u32 slot = header->count;
+    memcpy(store_segment_tile(segment, slot), tile->iterations, STORE_TILE_BYTES);
+    *store_segment_record(segment, slot) = (store_record_t) {
+            .level = tile->key.level,
+            .max_iterations = tile->max_iterations,
+            .x = tile->key.x,
+            .y = tile->key.y,
+            .precision = tile->precision,
+            .periodicity = tile->periodicity,
+            .attraction = tile->attraction,
+            .padding = {0, 0},
+    };
+    atomic_thread_fence(memory_order_release);
+    header->count = slot + 1;
+    store_index_insert(self, index, slot);
+    segment->indexed = slot + 1;
+}
@@ -0,0 +1,154 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_STORE_H
+#define LIBFRACTAL_STORE_H
+
+#include "cache.h"
+#include "types.h"
+
+/**
+ * Environment variable that names the directory of the pipeline's store, e.g.
+ * FRACTAL_STORE=/var/cache/mandelbrot. Without it tiles only live as long as the process
+ */
+#define STORE_ENVIRONMENT "FRACTAL_STORE"
+
+/**
+ * Disk budget of the pipeline's store in bytes
+ */
+#define STORE_BUDGET_DEFAULT (1ull << 30)
+
+/**
+ * Number of tiles a segment file holds
+ */
+#define STORE_SEGMENT_TILES 256
+
+/**
+ * Longest path of the store directory including the terminating zero
+ */
+#define STORE_PATH_LENGTH 1024
+
+/**
+ * Identity of a persisted tile, a tile is only valid for the precision and interior checks it
+ * was computed with
+ */
+typedef struct store_record {
+    s32 level;
+    u32 max_iterations;
+    s64 x;
+    s64 y;
+    u32 precision;
+    u8 periodicity;
+    u8 attraction;
+    u8 padding[2];
+} store_record_t;
+
+/**
+ * Start of every segment file, count records are valid. Segments of another kernel version or
+ * tile size are discarded
+ */
+typedef struct store_header {
+    u32 magic;
+    u32 version;
+    u32 tile_size;
+    u32 count;
+} store_header_t;
+
+/**
+ * A segment file mapped into memory. The header and STORE_SEGMENT_TILES records are followed
+ * by the tiles at a page aligned offset. Only the process that created a segment appends to
+ * it, segments of other processes are mapped read only. The first indexed records are in the
+ * index of the store.
+ */
+typedef struct store_segment {
+    u32 number;
+    bool owned;
+    u32 indexed;
+    u8 *data;
+} store_segment_t;
+
+/**
+ * Slot of the index, refers to the record at slot of the segment at index segment
+ */
+typedef struct store_entry {
+    u32 segment;
+    u32 slot;
+} store_entry_t;
+
+/**
+ * Persistent tier of the tile cache. Tiles are appended to memory mapped segment files in a
+ * directory which processes on the same host may share, a newer record of a tile replaces the
+ * older ones. An open addressing index of every record is built when the store is opened and
+ * whenever a segment is created, which also picks up the segments of other processes. Every
+ * segment file in the directory counts against the budget, the oldest segments are deleted as
+ * a whole to make room for a new one.
+ */
+typedef struct store {
+    char path[STORE_PATH_LENGTH];
+    store_segment_t *segments;
+    u32 count;
+    u32 limit;
+    store_entry_t *entries;
+    u32 entry_mask;
+} store_t;
+
+/**
+ * Opens the store in the specified directory and creates the directory if necessary
+ *
+ * @param self store handle
+ * @param path directory of the segment files
+ * @param budget disk budget in bytes, at least two segments are kept
+ * @return false if the directory can not be used, the store must not be used then
+ */
+bool store_open(store_t *self, const char *path, u64 budget);
+
+/**
+ * Unmaps all segments, the files are kept
+ *
+ * @param self store handle
+ */
+void store_close(store_t *self);
+
+/**
+ * Finds the newest persisted version of a tile, only its key, precision and checks are
+ * compared. A miss indexes the records other processes appended to known segments since and
+ * looks again. The iterations are not copied, they stay valid until the next store_write
+ *
+ * @param self store handle
+ * @param tile tile handle
+ * @param max_iterations pointer to the resulting iteration limit of the persisted tile
+ * @return pointer into the mapped segment, NULL if the tile was never persisted
+ */
+const u32 *store_find(store_t *self, const cache_tile_t *tile, u32 *max_iterations);
+
+/**
+ * Appends the tile to the newest segment of this process, a new segment is created when it is
+ * full which may delete the oldest ones
+ *
+ * @param self store handle
+ * @param tile tile handle
+ */
+void store_write(store_t *self, const cache_tile_t *tile);
+
+#endif// LIBFRACTAL_STORE_H
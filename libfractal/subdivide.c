@@ -0,0 +1,233 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "subdivide.h"
+#include "cpu.h"
+#include "math.h"
+
+#include <string.h>
+
+// Tiles that are handed to the pool, each one is subdivided on its own
+#define SUBDIVIDE_TILE 64
+
+// Rectangles with fewer inner rows or columns are evaluated completely
+#define SUBDIVIDE_MINIMUM 4
+
+// Splitting a tile never nests deeper than log2(SUBDIVIDE_TILE), with three pending
+// siblings per level
+#define SUBDIVIDE_STACK 32
+
+/**
+ * Rectangle of a tile with inclusive bounds, the outermost rows and columns are the border
+ */
+typedef struct subdivide_rect {
+    u32 x0;
+    u32 y0;
+    u32 x1;
+    u32 y1;
+} subdivide_rect_t;
+
+typedef struct subdivide_job {
+    const fractal_view_t *view;
+    const kernel_t *kernel;
+    fractal_precision_t precision;
+    const perturb_t *perturb;
+    u32 *iterations;
+    f32vec4_t *colors;
+    u32 tiles_x;
+    atomic_uint rejected;
+    atomic_uint periodic;
+    atomic_uint attracted;
+    atomic_uint filled;
+} subdivide_job_t;
+
+typedef struct subdivide_tile {
+    const subdivide_job_t *job;
+    u32 x0;
+    u32 y0;
+    bool done[SUBDIVIDE_TILE * SUBDIVIDE_TILE];
+    // Also holds the interior of rectangles below SUBDIVIDE_MINIMUM
+    u32 border[4 * SUBDIVIDE_TILE];
+    u32 pending[SUBDIVIDE_TILE * SUBDIVIDE_TILE];
+    kernel_stats_t stats;
+} subdivide_tile_t;
+
+static u32 subdivide_border(const subdivide_tile_t *self, subdivide_rect_t rect, u32 *result) {
+    // Corners are only listed once, rectangles of a single row or column as well
+    u32 width = self->job->view->width;
+    u32 count = 0;
+    for (u32 x = rect.x0; x <= rect.x1; x++) {
+        result[count++] = rect.y0 * width + x;
+        if (rect.y1 != rect.y0) {
+            result[count++] = rect.y1 * width + x;
+        }
+    }
+    for (u32 y = rect.y0 + 1; y < rect.y1; y++) {
+        result[count++] = y * width + rect.x0;
+        if (rect.x1 != rect.x0) {
+            result[count++] = y * width + rect.x1;
+        }
+    }
+    return count;
+}
+
+static void subdivide_evaluate(subdivide_tile_t *self, const u32 *pixels, u32 count) {
+    // Pixels shared with a neighbouring rectangle are only evaluated the first time
+    const subdivide_job_t *job = self->job;
+    u32 width = job->view->width;
+    u32 pending = 0;
+    for (u32 i = 0; i < count; i++) {
+        u32 local = (pixels[i] / width - self->y0) * SUBDIVIDE_TILE + (pixels[i] % width - self->x0);
+        if (!self->done[local]) {
+            self->done[local] = true;
+            self->pending[pending++] = pixels[i];
+        }
+    }
+    if (job->precision == FRACTAL_PRECISION_PERTURBATION) {
+        perturb_render_pixels(job->perturb, job->view, self->pending, pending, job->iterations, &self->stats);
+    } else {
+        fractal_cpu_render_pixels(job->view, job->kernel, job->precision, self->pending, pending, job->iterations,
+                                  &self->stats);
+    }
+}
+
+static void subdivide_rect(subdivide_tile_t *self, subdivide_rect_t rect, subdivide_rect_t *stack, u32 *top) {
+    u32 *iterations = self->job->iterations;
+    u32 width = self->job->view->width;
+    u32 count = subdivide_border(self, rect, self->border);
+    subdivide_evaluate(self, self->border, count);
+
+    // Rectangles of at most two rows or columns have no interior
+    if (rect.x1 - rect.x0 < 2 || rect.y1 - rect.y0 < 2) {
+        return;
+    }
+
+    bool uniform = true;
+    u32 value = iterations[self->border[0]];
+    for (u32 i = 1; i < count && uniform; i++) {
+        uniform = iterations[self->border[i]] == value;
+    }
+    if (uniform) {
+        for (u32 y = rect.y0 + 1; y < rect.y1; y++) {
+            for (u32 x = rect.x0 + 1; x < rect.x1; x++) {
+                iterations[y * width + x] = value;
+                self->done[(y - self->y0) * SUBDIVIDE_TILE + (x - self->x0)] = true;
+            }
+        }
+        self->stats.filled += (rect.x1 - rect.x0 - 1) * (rect.y1 - rect.y0 - 1);
+        return;
+    }
+
+    if (rect.x1 - rect.x0 - 1 < SUBDIVIDE_MINIMUM || rect.y1 - rect.y0 - 1 < SUBDIVIDE_MINIMUM) {
+        // The interior is handed over as a whole, the border just went through subdivide_evaluate
+        u32 interior = 0;
+        for (u32 y = rect.y0 + 1; y < rect.y1; y++) {
+            for (u32 x = rect.x0 + 1; x < rect.x1; x++) {
+                self->border[interior++] = y * width + x;
+            }
+        }
+        subdivide_evaluate(self, self->border, interior);
+        return;
+    }
+
+    // The children share the middle row and column, which is evaluated once by the first of them
+    u32 mx = (rect.x0 + rect.x1) / 2;
+    u32 my = (rect.y0 + rect.y1) / 2;
+    stack[(*top)++] = (subdivide_rect_t) {mx, my, rect.x1, rect.y1};
+    stack[(*top)++] = (subdivide_rect_t) {rect.x0, my, mx, rect.y1};
+    stack[(*top)++] = (subdivide_rect_t) {mx, rect.y0, rect.x1, my};
+    stack[(*top)++] = (subdivide_rect_t) {rect.x0, rect.y0, mx, my};
+}
+
+static void subdivide_render_tile(void *user, u32 tile, u32 worker) {
+    subdivide_job_t *job = user;
+    const fractal_view_t *view = job->view;
+    u32 x0 = (tile % job->tiles_x) * SUBDIVIDE_TILE;
+    u32 y0 = (tile / job->tiles_x) * SUBDIVIDE_TILE;
+    u32 x1 = (u32) s32_min((s32) (x0 + SUBDIVIDE_TILE), (s32) view->width);
+    u32 y1 = (u32) s32_min((s32) (y0 + SUBDIVIDE_TILE), (s32) view->height);
+
+    subdivide_tile_t state;
+    state.job = job;
+    state.x0 = x0;
+    state.y0 = y0;
+    memset(state.done, 0, sizeof(state.done));
+    memset(&state.stats, 0, sizeof(state.stats));
+
+    subdivide_rect_t stack[SUBDIVIDE_STACK];
+    u32 top = 0;
+    stack[top++] = (subdivide_rect_t) {x0, y0, x1 - 1, y1 - 1};
+    while (top > 0) {
+        subdivide_rect_t rect = stack[--top];
+        subdivide_rect(&state, rect, stack, &top);
+    }
+
+    if (job->colors) {
+        for (u32 y = y0; y < y1; y++) {
+            for (u32 x = x0; x < x1; x++) {
+                u32 index = y * view->width + x;
+                fractal_cpu_color(job->iterations[index], view->max_iterations, job->colors + index);
+            }
+        }
+    }
+    atomic_fetch_add(&job->rejected, state.stats.rejected);
+    atomic_fetch_add(&job->periodic, state.stats.periodic);
+    atomic_fetch_add(&job->attracted, state.stats.attracted);
+    atomic_fetch_add(&job->filled, state.stats.filled);
+}
+
+void subdivide_render(thread_pool_t *pool, perturb_t *perturb, const fractal_view_t *view, u32 *iterations,
+                      f32vec4_t *colors, kernel_stats_t *stats) {
+    // The reference orbit is computed once up front, the tiles only read it
+    subdivide_job_t job;
+    job.view = view;
+    job.kernel = kernel_select();
+    job.precision = fractal_view_precision(view);
+    job.perturb = perturb;
+    if (job.precision == FRACTAL_PRECISION_PERTURBATION) {
+        perturb_center_view(perturb, view);
+        perturb_prepare(perturb, view);
+    }
+    job.iterations = iterations;
+    job.colors = colors;
+    job.tiles_x = (view->width + SUBDIVIDE_TILE - 1) / SUBDIVIDE_TILE;
+    atomic_init(&job.rejected, 0);
+    atomic_init(&job.periodic, 0);
+    atomic_init(&job.attracted, 0);
+    atomic_init(&job.filled, 0);
+    u32 tiles = job.tiles_x * ((view->height + SUBDIVIDE_TILE - 1) / SUBDIVIDE_TILE);
+    if (pool) {
+        thread_pool_run(pool, tiles, subdivide_render_tile, &job);
+    } else {
+        for (u32 tile = 0; tile < tiles; tile++) {
+            subdivide_render_tile(&job, tile, 0);
+        }
+    }
+    if (stats) {
+        stats->rejected = atomic_load(&job.rejected);
+        stats->periodic = atomic_load(&job.periodic);
+        stats->attracted = atomic_load(&job.attracted);
+        stats->filled = atomic_load(&job.filled);
+    }
+}
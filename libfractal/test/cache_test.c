@@ -0,0 +1,187 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cache.h"
+
+// Zoom level of the views, deep enough for every tile to be distinct and shallow enough for floats
+#define CACHE_TEST_LEVEL 8
+
+#define CACHE_TEST_MAX_ITERATIONS 100
+
+// Memory a cache_create budget has to cover for every tile, see cache_create
+#define CACHE_TEST_TILE_BUDGET                                                                                         \
+    (CACHE_TILE_SIZE * CACHE_TILE_SIZE * sizeof(u32) + sizeof(cache_tile_t) + 2 * sizeof(u32))
+
+// Tiles the budget of the eviction test holds
+#define CACHE_TEST_CAPACITY 4
+
+static u32 cache_test_failures = 0;
+
+static void cache_test_check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "[cache_test] %s\n", what);
+        cache_test_failures++;
+    }
+}
+
+static void cache_test_view(fractal_view_t *view, s32 level, s64 x, s64 y, u32 width) {
+    // The view is one tile high and starts at lattice point (x, y), see fractal_view_lattice
+    fractal_view_create_default(view, width, CACHE_TILE_SIZE);
+    view->scale = exp2(-level);
+    view->center_x = ((f64) x + 0.5 * (f64) width - 0.5) * view->scale;
+    view->center_y = ((f64) y + 0.5 * CACHE_TILE_SIZE - 0.5) * view->scale;
+    view->max_iterations = CACHE_TEST_MAX_ITERATIONS;
+}
+
+static u32 cache_test_sample(s64 x, s64 y, u32 max_iterations) {
+    // Every count up to the limit appears in each tile, the limit included
+    return (u32) ((x * 7 + y * 3) % (max_iterations + 1));
+}
+
+static void cache_test_store(cache_t *cache, const fractal_view_t *view, s64 x, s64 y) {
+    static u32 iterations[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    for (u32 row = 0; row < view->height; row++) {
+        for (u32 column = 0; column < view->width; column++) {
+            iterations[row * view->width + column] = cache_test_sample(x + column, y + row, view->max_iterations);
+        }
+    }
+    cache_store(cache, view, iterations);
+}
+
+static bool cache_test_load(cache_t *cache, const fractal_view_t *view, s64 x, s64 y, u32 limit) {
+    // Samples below the limit of the stored tile are exact, those that reached it are only
+    // known if the limit of the view is not higher
+    static u32 iterations[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    u32 known = cache_load(cache, view, iterations);
+    u32 expected_known = 0;
+    bool equal = true;
+    for (u32 row = 0; row < view->height; row++) {
+        for (u32 column = 0; column < view->width; column++) {
+            u32 sample = cache_test_sample(x + column, y + row, limit);
+            u32 expected = sample < limit ? sample : CACHE_UNKNOWN;
+            if (view->max_iterations <= limit && sample >= view->max_iterations) {
+                expected = view->max_iterations;
+            }
+            expected_known += expected != CACHE_UNKNOWN;
+            equal = equal && iterations[row * view->width + column] == expected;
+        }
+    }
+    return equal && known == expected_known;
+}
+
+static void cache_test_eviction(void) {
+    // Loading a tile makes it the most recently used one, the oldest tiles are evicted in order
+    cache_t cache;
+    cache_create(&cache, CACHE_TEST_CAPACITY * CACHE_TEST_TILE_BUDGET);
+    cache_test_check(cache.capacity == CACHE_TEST_CAPACITY, "the budget does not hold the expected number of tiles");
+    fractal_view_t views[CACHE_TEST_CAPACITY + 2];
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(views); i++) {
+        cache_test_view(views + i, CACHE_TEST_LEVEL, i * CACHE_TILE_SIZE, 0, CACHE_TILE_SIZE);
+    }
+    for (u32 i = 0; i < CACHE_TEST_CAPACITY; i++) {
+        cache_test_store(&cache, views + i, i * CACHE_TILE_SIZE, 0);
+    }
+    cache_test_check(cache_test_load(&cache, views, 0, 0, CACHE_TEST_MAX_ITERATIONS), "stored tile is not loaded");
+    cache_test_store(&cache, views + CACHE_TEST_CAPACITY, CACHE_TEST_CAPACITY * CACHE_TILE_SIZE, 0);
+    cache_test_store(&cache, views + CACHE_TEST_CAPACITY + 1, (CACHE_TEST_CAPACITY + 1) * CACHE_TILE_SIZE, 0);
+    cache_test_check(cache.count == CACHE_TEST_CAPACITY, "the cache outgrew its budget");
+
+    // Tiles 1 and 2 were the oldest ones, the one loaded before survives
+    static const bool survivors[CACHE_TEST_CAPACITY + 2] = {true, false, false, true, true, true};
+    u32 iterations[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(views); i++) {
+        if (survivors[i]) {
+            cache_test_check(cache_test_load(&cache, views + i, i * CACHE_TILE_SIZE, 0, CACHE_TEST_MAX_ITERATIONS),
+                             "surviving tile is not loaded");
+        } else {
+            cache_test_check(cache_load(&cache, views + i, iterations) == 0, "evicted tile is still known");
+        }
+    }
+    cache_destroy(&cache);
+}
+
+static void cache_test_limits(void) {
+    // A raised limit leaves the samples that reached the previous one unknown, a lowered
+    // limit clamps them
+    cache_t cache;
+    cache_create(&cache, CACHE_BUDGET_DEFAULT);
+    fractal_view_t view;
+    cache_test_view(&view, CACHE_TEST_LEVEL, 0, 0, CACHE_TILE_SIZE);
+    cache_test_store(&cache, &view, 0, 0);
+    view.max_iterations = 2 * CACHE_TEST_MAX_ITERATIONS;
+    cache_test_check(cache_test_load(&cache, &view, 0, 0, CACHE_TEST_MAX_ITERATIONS),
+                     "raised limit does not leave the samples at the limit unknown");
+    view.max_iterations = CACHE_TEST_MAX_ITERATIONS / 2;
+    cache_test_check(cache_test_load(&cache, &view, 0, 0, CACHE_TEST_MAX_ITERATIONS),
+                     "lowered limit does not clamp the samples");
+
+    // Storing at the lower limit clamps the tile for good
+    cache_test_store(&cache, &view, 0, 0);
+    view.max_iterations = CACHE_TEST_MAX_ITERATIONS;
+    cache_test_check(cache_test_load(&cache, &view, 0, 0, CACHE_TEST_MAX_ITERATIONS / 2),
+                     "tile stored at the lowered limit does not know its limit");
+    cache_destroy(&cache);
+}
+
+static void cache_test_compatibility(void) {
+    // Samples taken with other interior checks or another precision may end differently
+    cache_t cache;
+    cache_create(&cache, CACHE_BUDGET_DEFAULT);
+    u32 iterations[2 * CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    fractal_view_t view;
+    cache_test_view(&view, CACHE_TEST_LEVEL, 0, 0, CACHE_TILE_SIZE);
+    cache_test_store(&cache, &view, 0, 0);
+    fractal_view_t other = view;
+    other.periodicity = true;
+    cache_test_check(cache_load(&cache, &other, iterations) == 0, "tile is known with periodicity checking");
+    other = view;
+    other.attraction = true;
+    cache_test_check(cache_load(&cache, &other, iterations) == 0, "tile is known with the attraction test");
+
+    // The tile just below 4 at level 17 is sampled in floats, a view that reaches beyond 4
+    // needs doubles for the same points
+    s64 edge = 4ll << 17;
+    cache_test_view(&view, 17, edge - CACHE_TILE_SIZE, 0, CACHE_TILE_SIZE);
+    cache_test_store(&cache, &view, edge - CACHE_TILE_SIZE, 0);
+    cache_test_view(&other, 17, edge - CACHE_TILE_SIZE, 0, 2 * CACHE_TILE_SIZE);
+    cache_test_check(fractal_view_precision(&view) == FRACTAL_PRECISION_F32 &&
+                             fractal_view_precision(&other) == FRACTAL_PRECISION_F64,
+                     "views around 4 do not differ in precision");
+    cache_test_check(cache_load(&cache, &other, iterations) == 0, "tile is known at a different precision");
+    cache_test_check(cache_test_load(&cache, &view, edge - CACHE_TILE_SIZE, 0, CACHE_TEST_MAX_ITERATIONS),
+                     "tile is not known at its own precision");
+    cache_destroy(&cache);
+}
+
+int main(void) {
+    cache_test_eviction();
+    cache_test_limits();
+    cache_test_compatibility();
+    printf("[cache_test] %u failures\n", cache_test_failures);
+    return cache_test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fixed.h"
+
+// Limb counts of the short products, the threshold itself, an uneven split and the maximum
+#define FIXED_TEST_COUNTS 3
+
+static u32 fixed_test_failures = 0;
+
+static void fixed_test_check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "[fixed_test] %s\n", what);
+        fixed_test_failures++;
+    }
+}
+
+static void fixed_test_random(fixed_t *self, u32 count) {
+    // Small integer parts keep the products within 32 bits
+    fixed_zero(self);
+    self->limbs[0] = (u32) rand() % 4;
+    for (u32 i = 1; i < count; i++) {
+        self->limbs[i] = (u32) rand() << 16 ^ (u32) rand();
+    }
+    self->negative = rand() % 2;
+}
+
+static void fixed_test_reference(const fixed_t *a, const fixed_t *b, fixed_t *result, u32 count) {
+    // The exact schoolbook product of every column, cut off after count limbs
+    static u64 low[2 * FIXED_MAX_LIMBS];
+    static u64 high[2 * FIXED_MAX_LIMBS];
+    for (u32 k = 0; k + 1 < 2 * count; k++) {
+        low[k] = 0;
+        high[k] = 0;
+        for (u32 i = k < count ? 0 : k - count + 1; i <= k && i < count; i++) {
+            u64 product = (u64) a->limbs[i] * b->limbs[k - i];
+            low[k] += (u32) product;
+            high[k] += product >> 32;
+        }
+    }
+    fixed_zero(result);
+    u64 carry = 0;
+    for (u32 k = 2 * count - 1; k-- > 0;) {
+        u64 column = low[k] + carry;
+        if (k < count) {
+            result->limbs[k] = (u32) column;
+        }
+        carry = (column >> 32) + high[k];
+    }
+    result->negative = a->negative != b->negative;
+}
+
+static bool fixed_test_close(const fixed_t *a, const fixed_t *b, u32 count) {
+    // Products drop the columns below the last limb, each of the count columns right below
+    // may carry one unit of the second to last limb
+    fixed_t difference;
+    fixed_sub(a, b, &difference, count);
+    for (u32 i = 0; i + 2 < count; i++) {
+        if (difference.limbs[i] != 0) {
+            return false;
+        }
+    }
+    return difference.limbs[count - 2] <= count;
+}
+
+static bool fixed_test_product(const fixed_t *a, const char *expected, u32 count) {
+    fixed_t b;
+    fixed_from_string(&b, expected);
+    return fixed_test_close(a, &b, count) && a->negative == b.negative;
+}
+
+static void fixed_test_short(void) {
+    static const u32 counts[FIXED_TEST_COUNTS] = {FIXED_KARATSUBA_THRESHOLD, 3 * FIXED_KARATSUBA_THRESHOLD / 2 + 7,
+                                                  FIXED_MAX_LIMBS};
+    static fixed_t a, b, expected, actual;
+    srand(1);
+    for (u32 i = 0; i < FIXED_TEST_COUNTS; i++) {
+        u32 count = counts[i];
+        fixed_test_random(&a, count);
+        fixed_test_random(&b, count);
+        fixed_test_reference(&a, &b, &expected, count);
+        fixed_mul(&a, &b, &actual, count);
+        fixed_test_check(fixed_test_close(&expected, &actual, count), "short product differs from schoolbook");
+
+        fixed_test_reference(&a, &a, &expected, count);
+        expected.negative = false;
+        fixed_square(&a, &actual, count);
+        fixed_test_check(fixed_test_close(&expected, &actual, count), "short square differs from schoolbook");
+
+        // The result may alias a factor
+        actual = a;
+        fixed_mul(&actual, &b, &actual, count);
+        fixed_test_reference(&a, &b, &expected, count);
+        fixed_test_check(fixed_test_close(&expected, &actual, count), "aliased short product differs");
+    }
+}
+
+static void fixed_test_products(void) {
+    // Both below and above the threshold
+    static const u32 counts[] = {4, FIXED_KARATSUBA_THRESHOLD};
+    static fixed_t a, b, result;
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(counts); i++) {
+        u32 count = counts[i];
+        fixed_from_string(&a, "1.5");
+        fixed_from_string(&b, "-2.25");
+        fixed_mul(&a, &b, &result, count);
+        fixed_test_check(fixed_test_product(&result, "-3.375", count), "1.5 * -2.25 is not -3.375");
+
+        fixed_from_string(&a, "123.456");
+        fixed_from_string(&b, "-0.001");
+        fixed_mul(&a, &b, &result, count);
+        fixed_test_check(fixed_test_product(&result, "-0.123456", count), "123.456 * -0.001 is off");
+
+        fixed_from_string(&a, "-0.1");
+        fixed_mul(&a, &a, &result, count);
+        fixed_test_check(fixed_test_product(&result, "0.01", count), "-0.1 * -0.1 is off");
+        fixed_square(&a, &result, count);
+        fixed_test_check(fixed_test_product(&result, "0.01", count), "-0.1^2 is off");
+    }
+}
+
+static void fixed_test_sums(void) {
+    static fixed_t a, b, result;
+    fixed_from_string(&a, "1.25");
+    fixed_from_string(&b, "3.5");
+    fixed_sub(&a, &b, &result, 4);
+    fixed_test_check(fixed_to_f64(&result, 4) == -2.25, "1.25 - 3.5 is not -2.25");
+    a.negative = true;
+    fixed_add(&a, &b, &result, 4);
+    fixed_test_check(fixed_to_f64(&result, 4) == 2.25, "-1.25 + 3.5 is not 2.25");
+    fixed_add(&b, &a, &result, 4);
+    fixed_test_check(fixed_to_f64(&result, 4) == 2.25, "3.5 + -1.25 is not 2.25");
+    fixed_sub(&a, &b, &result, 4);
+    fixed_test_check(fixed_to_f64(&result, 4) == -4.75, "-1.25 - 3.5 is not -4.75");
+    fixed_sub(&a, &a, &result, 4);
+    fixed_test_check(fixed_to_f64(&result, 4) == 0.0, "-1.25 - -1.25 is not 0");
+
+    // Carries and borrows run through every limb
+    fixed_zero(&a);
+    fixed_zero(&b);
+    for (u32 i = 1; i < 4; i++) {
+        a.limbs[i] = 0xffffffffu;
+    }
+    b.limbs[3] = 1;
+    fixed_add(&a, &b, &result, 4);
+    fixed_test_check(result.limbs[0] == 1 && result.limbs[1] == 0 && result.limbs[3] == 0, "carry is lost");
+    fixed_sub(&result, &b, &result, 4);
+    fixed_test_check(result.limbs[0] == 0 && result.limbs[1] == 0xffffffffu && result.limbs[3] == 0xffffffffu,
+                     "borrow is lost");
+}
+
+static void fixed_test_conversion(void) {
+    static fixed_t value;
+
+    // 1 + 2^-53 lies halfway between two doubles and rounds to the even one, any bit below breaks the tie
+    fixed_zero(&value);
+    value.limbs[0] = 1;
+    value.limbs[2] = 1u << 11;
+    fixed_test_check(fixed_to_f64(&value, 8) == 1.0, "tie does not round to even");
+    value.limbs[2] = 3u << 11;
+    fixed_test_check(fixed_to_f64(&value, 8) == 1.0 + 0x1p-51, "tie does not round to even");
+    value.limbs[2] = 1u << 11;
+    value.limbs[60] = 1;
+    fixed_test_check(fixed_to_f64(&value, 64) == 1.0 + 0x1p-52, "sticky bit is lost");
+    fixed_test_check(fixed_to_f64(&value, 8) == 1.0, "limbs beyond the count are used");
+    value.negative = true;
+    fixed_test_check(fixed_to_f64(&value, 64) == -1.0 - 0x1p-52, "sign is lost");
+
+    // Tiny values are exact down to the subnormals and vanish below them
+    fixed_zero(&value);
+    value.limbs[10] = 3;
+    fixed_test_check(fixed_to_f64(&value, 16) == 3.0 * 0x1p-320, "tiny value is not exact");
+    fixed_zero(&value);
+    value.limbs[33] = 1;
+    fixed_test_check(fixed_to_f64(&value, 64) == 0x1p-1056, "subnormal value is not exact");
+    fixed_zero(&value);
+    value.limbs[40] = 1;
+    fixed_test_check(fixed_to_f64(&value, 64) == 0.0, "value below the subnormals is not zero");
+
+    fixed_from_f64(&value, -0.7436438870371587);
+    fixed_test_check(fixed_to_f64(&value, FIXED_MAX_LIMBS) == -0.7436438870371587, "double does not round trip");
+}
+
+static void fixed_test_strings(void) {
+    static const char *valid[] = {"0", "-0.5", "+2.75", "3", ".25", "7.", "4294967295", "-0.0009765625"};
+    static const f64 values[] = {0.0, -0.5, 2.75, 3.0, 0.25, 7.0, 4294967295.0, -0.0009765625};
+    static const char *invalid[] = {"", "-", "+", ".", "-.", "1.2.3", "abc", "1e5", " 1", "4294967296"};
+    static fixed_t value;
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(valid); i++) {
+        bool parsed = fixed_from_string(&value, valid[i]);
+        if (!parsed || fixed_to_f64(&value, FIXED_MAX_LIMBS) != values[i]) {
+            fprintf(stderr, "[fixed_test] \"%s\" is not parsed as %g\n", valid[i], values[i]);
+            fixed_test_failures++;
+        }
+    }
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(invalid); i++) {
+        if (fixed_from_string(&value, invalid[i])) {
+            fprintf(stderr, "[fixed_test] \"%s\" is accepted\n", invalid[i]);
+            fixed_test_failures++;
+        }
+    }
+
+    // A decimal fraction is as close as the limbs allow, 0.1 is one unit below the exact value
+    fixed_from_string(&value, "0.1");
+    fixed_test_check(value.limbs[1] == 0x19999999u && value.limbs[FIXED_MAX_LIMBS - 1] == 0x99999999u,
+                     "0.1 is not parsed to the last limb");
+}
+
+int main(void) {
+    fixed_test_short();
+    fixed_test_products();
+    fixed_test_sums();
+    fixed_test_conversion();
+    fixed_test_strings();
+    printf("[fixed_test] %u failures\n", fixed_test_failures);
+    return fixed_test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
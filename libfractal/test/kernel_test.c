@@ -0,0 +1,136 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "kernel.h"
+
+// Points per batch, odd so that every kernel runs its remainder path
+#define KERNEL_TEST_POINTS 4099
+#define KERNEL_TEST_MAX_ITERATIONS 2000
+
+typedef struct kernel_test_points {
+    f32 fx[KERNEL_TEST_POINTS];
+    f32 fy[KERNEL_TEST_POINTS];
+    f64 dx[KERNEL_TEST_POINTS];
+    f64 dy[KERNEL_TEST_POINTS];
+    ddouble_t qx[KERNEL_TEST_POINTS];
+    ddouble_t qy[KERNEL_TEST_POINTS];
+} kernel_test_points_t;
+
+typedef struct kernel_test_results {
+    u32 iterations[KERNEL_TEST_POINTS];
+    f64 distances[KERNEL_TEST_POINTS];
+    kernel_stats_t stats;
+} kernel_test_results_t;
+
+static void kernel_test_generate(kernel_test_points_t *points, f64 x, f64 y, f64 radius, u32 seed) {
+    // Points in a square around (x, y), the double-double points carry a low part as well
+    srand(seed);
+    for (u32 i = 0; i < KERNEL_TEST_POINTS; i++) {
+        points->dx[i] = x + radius * (2.0 * rand() / (f64) RAND_MAX - 1.0);
+        points->dy[i] = y + radius * (2.0 * rand() / (f64) RAND_MAX - 1.0);
+        points->fx[i] = (f32) points->dx[i];
+        points->fy[i] = (f32) points->dy[i];
+        points->qx[i] = (ddouble_t) {points->dx[i], points->dx[i] * 0x1p-60};
+        points->qy[i] = (ddouble_t) {points->dy[i], -points->dy[i] * 0x1p-60};
+    }
+}
+
+static u32 kernel_test_compare(const char *kernel, const char *precision, u32 checks,
+                               const kernel_test_results_t *expected, const kernel_test_results_t *actual,
+                               bool distances) {
+    u32 failures = 0;
+    for (u32 i = 0; i < KERNEL_TEST_POINTS; i++) {
+        failures += expected->iterations[i] != actual->iterations[i];
+        failures += distances && expected->distances[i] != actual->distances[i];
+    }
+    failures += expected->stats.rejected != actual->stats.rejected;
+    failures += expected->stats.periodic != actual->stats.periodic;
+    failures += expected->stats.attracted != actual->stats.attracted;
+    if (failures) {
+        fprintf(stderr, "[kernel_test] %s %s with checks %u differs from scalar in %u values\n", kernel, precision,
+                checks, failures);
+    }
+    return failures;
+}
+
+static u32 kernel_test_run(const kernel_t *kernel, const kernel_test_points_t *points) {
+    static kernel_test_results_t expected;
+    static kernel_test_results_t actual;
+    const u32 count = KERNEL_TEST_POINTS;
+    const u32 limit = KERNEL_TEST_MAX_ITERATIONS;
+    u32 failures = 0;
+    for (u32 checks = 0; checks <= (KERNEL_CHECK_PERIODICITY | KERNEL_CHECK_ATTRACTION); checks++) {
+        expected.stats = actual.stats = (kernel_stats_t) {0};
+        kernel_scalar.f32(points->fx, points->fy, count, limit, checks, expected.iterations, &expected.stats);
+        kernel->f32(points->fx, points->fy, count, limit, checks, actual.iterations, &actual.stats);
+        failures += kernel_test_compare(kernel->name, "f32", checks, &expected, &actual, false);
+
+        expected.stats = actual.stats = (kernel_stats_t) {0};
+        kernel_scalar.f64(points->dx, points->dy, count, limit, checks, expected.iterations, &expected.stats);
+        kernel->f64(points->dx, points->dy, count, limit, checks, actual.iterations, &actual.stats);
+        failures += kernel_test_compare(kernel->name, "f64", checks, &expected, &actual, false);
+
+        if (kernel->ddouble) {
+            expected.stats = actual.stats = (kernel_stats_t) {0};
+            kernel_scalar.ddouble(points->qx, points->qy, count, limit, checks, expected.iterations, &expected.stats);
+            kernel->ddouble(points->qx, points->qy, count, limit, checks, actual.iterations, &actual.stats);
+            failures += kernel_test_compare(kernel->name, "ddouble", checks, &expected, &actual, false);
+        }
+    }
+    if (kernel->distance) {
+        expected.stats = actual.stats = (kernel_stats_t) {0};
+        kernel_scalar.distance(points->dx, points->dy, count, limit, expected.iterations, expected.distances,
+                               &expected.stats);
+        kernel->distance(points->dx, points->dy, count, limit, actual.iterations, actual.distances, &actual.stats);
+        failures += kernel_test_compare(kernel->name, "distance", 0, &expected, &actual, true);
+    }
+    return failures;
+}
+
+int main(void) {
+    // The whole set, a region along the boundary and a deeper one where f32 runs out of precision
+    static kernel_test_points_t points;
+    static const f64 regions[][3] = {
+            {-0.75, 0.0, 1.5},
+            {-0.7436438870371587, 0.1318259042053119, 1e-3},
+            {-1.7497591451303665, 0.0, 1e-9},
+    };
+    u32 failures = 0;
+    u32 tested = 0;
+    for (u32 region = 0; region < STACK_ARRAY_SIZE(regions); region++) {
+        kernel_test_generate(&points, regions[region][0], regions[region][1], regions[region][2], region + 1);
+        for (u32 type = KERNEL_SCALAR + 1; type < KERNEL_COUNT; type++) {
+            const kernel_t *kernel = kernel_get((kernel_type_t) type);
+            if (kernel) {
+                failures += kernel_test_run(kernel, &points);
+                tested++;
+            }
+        }
+    }
+    printf("[kernel_test] %u kernel runs, %u differences\n", tested, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
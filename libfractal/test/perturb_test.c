@@ -0,0 +1,123 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cpu.h"
+#include "perturb.h"
+
+#define PERTURB_TEST_WIDTH 160
+#define PERTURB_TEST_HEIGHT 120
+#define PERTURB_TEST_MAX_ITERATIONS 20000
+
+// Iteration limit of the comparison with direct double-double evaluation
+#define PERTURB_TEST_REFERENCE_ITERATIONS 5000
+
+// Chaotic pixels near the boundary end up a few iterations apart with any change in rounding,
+// approximations may change at most this share of the pixels of plain perturbation
+#define PERTURB_TEST_TOLERANCE 0.01
+
+// Share of the pixels in which plain perturbation may differ from double-double
+#define PERTURB_TEST_REFERENCE_TOLERANCE 0.002
+
+static u32 perturb_test_compare(const char *method, const char *reference, const fractal_view_t *view,
+                                const u32 *expected, const u32 *actual, f64 tolerance) {
+    u32 count = view->width * view->height;
+    u32 differences = 0;
+    for (u32 i = 0; i < count; i++) {
+        differences += expected[i] != actual[i];
+    }
+    if (differences > tolerance * count) {
+        fprintf(stderr, "[perturb_test] %s at scale %g differs from %s in %u pixels\n", method, view->scale,
+                reference, differences);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    // Views around a boundary point from just beyond double precision to far beyond double-double
+    static u32 expected[PERTURB_TEST_WIDTH * PERTURB_TEST_HEIGHT];
+    static u32 actual[PERTURB_TEST_WIDTH * PERTURB_TEST_HEIGHT];
+    static const f64 scales[] = {1e-10, 1e-20, 1e-40};
+    fractal_view_t view;
+    fractal_view_create_default(&view, PERTURB_TEST_WIDTH, PERTURB_TEST_HEIGHT);
+    view.center_x = -0.7436438870371587;
+    view.center_x_low = 4.75e-18;
+    view.center_y = 0.1318259042053119;
+    view.center_y_low = 1e-18;
+    view.max_iterations = PERTURB_TEST_MAX_ITERATIONS;
+
+    perturb_t perturb;
+    perturb_create(&perturb);
+    perturb_center_view(&perturb, &view);
+    u32 failures = 0;
+    u32 skipped = 0;
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(scales); i++) {
+        view.scale = scales[i];
+        perturb_series(&perturb, false);
+        perturb_bla(&perturb, false);
+        perturb_render(&perturb, NULL, &view, expected);
+
+        perturb_series(&perturb, true);
+        perturb_render(&perturb, NULL, &view, actual);
+        failures +=
+                perturb_test_compare("series", "plain perturbation", &view, expected, actual, PERTURB_TEST_TOLERANCE);
+        skipped += perturb.series_skip > 0;
+
+        perturb_bla(&perturb, true);
+        perturb_render(&perturb, NULL, &view, actual);
+        failures +=
+                perturb_test_compare("bilinear", "plain perturbation", &view, expected, actual, PERTURB_TEST_TOLERANCE);
+    }
+
+    // Perturbation itself has to agree with evaluating every pixel directly, at a depth where
+    // double precision alone is far off and double-double is still exact enough
+    static u32 pixels[PERTURB_TEST_WIDTH * PERTURB_TEST_HEIGHT];
+    u32 count = view.width * view.height;
+    for (u32 i = 0; i < count; i++) {
+        pixels[i] = i;
+    }
+    view.scale = 1e-12;
+    view.max_iterations = PERTURB_TEST_REFERENCE_ITERATIONS;
+    view.periodicity = false;
+    view.attraction = false;
+    kernel_stats_t stats = {0};
+    fractal_cpu_render_pixels(&view, &kernel_scalar, FRACTAL_PRECISION_DDOUBLE, pixels, count, expected, &stats);
+    perturb_series(&perturb, false);
+    perturb_bla(&perturb, false);
+    perturb_render(&perturb, NULL, &view, actual);
+    failures += perturb_test_compare("perturbation", "double-double", &view, expected, actual,
+                                     PERTURB_TEST_REFERENCE_TOLERANCE);
+    perturb_destroy(&perturb);
+
+    // The validity check of the series must not reject every view either
+    if (skipped == 0) {
+        fprintf(stderr, "[perturb_test] the series approximation never skipped an iteration\n");
+        failures++;
+    }
+    printf("[perturb_test] %u views, %u with skipped iterations, %u failures\n",
+           (u32) STACK_ARRAY_SIZE(scales), skipped, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
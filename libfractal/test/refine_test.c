@@ -0,0 +1,140 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "refine.h"
+
+#define REFINE_TEST_WIDTH 160
+#define REFINE_TEST_HEIGHT 120
+
+// Limit of the first view, the pans below raise and lower it
+#define REFINE_TEST_MAX_ITERATIONS 500
+
+typedef struct refine_test_pan {
+    s32 dx;
+    s32 dy;
+    u32 max_iterations;
+} refine_test_pan_t;
+
+static void refine_test_finish(refine_t *self) {
+    while (refine_step(self, NULL)) {
+    }
+}
+
+static u32 refine_test_compare(const char *method, const refine_t *refine) {
+    // A fresh refinement of the same view evaluates every pixel on its own
+    refine_t fresh;
+    refine_create(&fresh);
+    refine_reset(&fresh, &refine->view);
+    refine_test_finish(&fresh);
+    u32 count = refine->view.width * refine->view.height;
+    u32 differences = 0;
+    for (u32 i = 0; i < count; i++) {
+        differences += refine->iterations[i] != fresh.iterations[i] || refine->values[i] != fresh.values[i];
+    }
+    refine_destroy(&fresh);
+    if (differences > 0 || !refine_complete(refine)) {
+        fprintf(stderr, "[refine_test] %s differs from a fresh refinement in %u pixels\n", method, differences);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    // A region with detail everywhere, on the global lattice so that pans keep the samples
+    fractal_view_t view;
+    fractal_view_create_default(&view, REFINE_TEST_WIDTH, REFINE_TEST_HEIGHT);
+    view.center_x = -0.16;
+    view.center_y = 1.035;
+    view.scale = 0.001;
+    view.max_iterations = REFINE_TEST_MAX_ITERATIONS;
+    fractal_view_snap(&view);
+
+    refine_t refine;
+    refine_create(&refine);
+    refine_reset(&refine, &view);
+    refine_test_finish(&refine);
+
+    // Pans in every direction, by most of the view and with a raised and a lowered limit
+    static const refine_test_pan_t pans[] = {
+            {37, -11, REFINE_TEST_MAX_ITERATIONS},
+            {-150, 4, REFINE_TEST_MAX_ITERATIONS},
+            {5, 110, 2 * REFINE_TEST_MAX_ITERATIONS},
+            {-20, -64, REFINE_TEST_MAX_ITERATIONS / 2},
+    };
+    u32 failures = 0;
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(pans); i++) {
+        fractal_view_pan(&view, pans[i].dx, pans[i].dy);
+        view.max_iterations = pans[i].max_iterations;
+        if (!refine_translate(&refine, NULL, &view)) {
+            fprintf(stderr, "[refine_test] pan by (%d, %d) was not reused\n", pans[i].dx, pans[i].dy);
+            failures++;
+            refine_reset(&refine, &view);
+            refine_test_finish(&refine);
+            continue;
+        }
+        failures += refine_test_compare("pan", &refine);
+    }
+
+    // Nothing of the view is left after a pan by more than its size
+    fractal_view_t away = view;
+    fractal_view_pan(&away, 2 * REFINE_TEST_WIDTH, 0);
+    if (refine_translate(&refine, NULL, &away)) {
+        fprintf(stderr, "[refine_test] pan beyond the view was reused\n");
+        failures++;
+    }
+
+    // Zooms anchored at the corners and edges of the view, where the least of the previous
+    // samples is kept. Zooming in leaves the last level to evaluate, zooming out is complete
+    const f64 anchors[][2] = {
+            {0.0, 0.0},
+            {REFINE_TEST_WIDTH - 1, 0.0},
+            {0.0, REFINE_TEST_HEIGHT - 1},
+            {REFINE_TEST_WIDTH - 1, REFINE_TEST_HEIGHT - 1},
+            {REFINE_TEST_WIDTH / 2, REFINE_TEST_HEIGHT - 1},
+            {REFINE_TEST_WIDTH - 1, REFINE_TEST_HEIGHT / 2 + 1},
+    };
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(anchors); i++) {
+        for (u32 out = 0; out < 2; out++) {
+            fractal_view_zoom_aligned(&view, anchors[i][0], anchors[i][1], !out);
+            if (!refine_zoom(&refine, NULL, &view)) {
+                fprintf(stderr, "[refine_test] zoom at (%g, %g) was not reused\n", anchors[i][0], anchors[i][1]);
+                failures++;
+                refine_reset(&refine, &view);
+            } else if (out && !refine_complete(&refine)) {
+                fprintf(stderr, "[refine_test] zoom out at (%g, %g) is not complete\n", anchors[i][0], anchors[i][1]);
+                failures++;
+            }
+            refine_test_finish(&refine);
+            failures += refine_test_compare(out ? "zoom out" : "zoom in", &refine);
+        }
+    }
+    refine_destroy(&refine);
+
+    printf("[refine_test] %u pans, %u zooms, %u failures\n", (u32) STACK_ARRAY_SIZE(pans),
+           2 * (u32) STACK_ARRAY_SIZE(anchors), failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
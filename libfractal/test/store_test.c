@@ -0,0 +1,210 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "store.h"
+
+// Directory of the segment files, relative to where the test runs
+#define STORE_TEST_PATH "store_test.segments"
+
+// Segment numbers that are removed before and after the test
+#define STORE_TEST_NUMBERS 16
+
+// Tiles that fill the first segment and start the second one
+#define STORE_TEST_TILES (STORE_SEGMENT_TILES + 44)
+
+// Tiles that are written twice, once with the older record in the first segment and once with
+// both records in the second one
+#define STORE_TEST_ACROSS 3
+#define STORE_TEST_WITHIN (STORE_SEGMENT_TILES + 24)
+
+#define STORE_TEST_MAX_ITERATIONS 1000
+
+static u32 store_test_failures = 0;
+
+static void store_test_check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "[store_test] %s\n", what);
+        store_test_failures++;
+    }
+}
+
+static void store_test_segment(u32 number, char *result) {
+    snprintf(result, STORE_PATH_LENGTH, STORE_TEST_PATH "/segment-%08u.tiles", number);
+}
+
+static u32 store_test_files(bool remove_files) {
+    // Segment files in the directory, which are deleted on request
+    u32 count = 0;
+    for (u32 number = 0; number < STORE_TEST_NUMBERS; number++) {
+        char path[STORE_PATH_LENGTH];
+        store_test_segment(number, path);
+        FILE *file = fopen(path, "rb");
+        if (file) {
+            fclose(file);
+            count++;
+            if (remove_files) {
+                remove(path);
+            }
+        }
+    }
+    return count;
+}
+
+static void store_test_tile(cache_tile_t *tile, s64 x, u32 seed) {
+    // Every tile and version of a tile holds different samples
+    tile->key = (cache_key_t) {8, x, -3};
+    tile->max_iterations = STORE_TEST_MAX_ITERATIONS + seed;
+    tile->precision = FRACTAL_PRECISION_F64;
+    tile->periodicity = true;
+    tile->attraction = false;
+    for (u32 i = 0; i < CACHE_TILE_SIZE * CACHE_TILE_SIZE; i++) {
+        tile->iterations[i] = (u32) (x * 31 + seed * 7 + i) % STORE_TEST_MAX_ITERATIONS;
+    }
+}
+
+static bool store_test_find(store_t *store, s64 x, u32 seed) {
+    // The persisted tile has to match the one store_test_tile creates
+    static u32 expected[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    cache_tile_t tile;
+    tile.iterations = expected;
+    store_test_tile(&tile, x, seed);
+    u32 max_iterations;
+    const u32 *samples = store_find(store, &tile, &max_iterations);
+    return samples && max_iterations == tile.max_iterations && memcmp(samples, expected, sizeof(expected)) == 0;
+}
+
+static bool store_test_missing(store_t *store, s64 x) {
+    static u32 samples[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    cache_tile_t tile;
+    tile.iterations = samples;
+    store_test_tile(&tile, x, 0);
+    u32 max_iterations;
+    return store_find(store, &tile, &max_iterations) == NULL;
+}
+
+static void store_test_write(store_t *store, s64 x, u32 seed) {
+    static u32 samples[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    cache_tile_t tile;
+    tile.iterations = samples;
+    store_test_tile(&tile, x, seed);
+    store_write(store, &tile);
+}
+
+static void store_test_reopen(void) {
+    // Records survive closing the store, the record that was written last wins whether the
+    // older one is in the same segment or in an older one
+    store_t store;
+    store_test_check(store_open(&store, STORE_TEST_PATH, STORE_BUDGET_DEFAULT), "store can not be opened");
+    for (u32 x = 0; x < STORE_TEST_TILES; x++) {
+        store_test_write(&store, x, 0);
+    }
+    store_test_write(&store, STORE_TEST_ACROSS, 1);
+    store_test_write(&store, STORE_TEST_WITHIN, 1);
+    store_test_check(store_test_find(&store, STORE_TEST_ACROSS, 1) && store_test_find(&store, STORE_TEST_WITHIN, 1),
+                     "rewritten tile is not the newest record");
+    store_close(&store);
+
+    store_test_check(store_open(&store, STORE_TEST_PATH, STORE_BUDGET_DEFAULT), "store can not be reopened");
+    store_test_check(store.count == 2, "reopened store does not map both segments");
+    bool found = true;
+    for (u32 x = 0; x < STORE_TEST_TILES; x++) {
+        found = found && store_test_find(&store, x, x == STORE_TEST_ACROSS || x == STORE_TEST_WITHIN);
+    }
+    store_test_check(found, "tiles are lost or outdated after reopening");
+    store_test_check(store_test_missing(&store, STORE_TEST_TILES), "tile that was never written is found");
+    store_close(&store);
+}
+
+static void store_test_version(void) {
+    // A segment of another kernel version is deleted when the store is opened
+    char path[STORE_PATH_LENGTH];
+    store_test_segment(0, path);
+    FILE *file = fopen(path, "r+b");
+    store_test_check(file != NULL, "first segment does not exist");
+    if (file) {
+        u32 version = KERNEL_VERSION + 1;
+        fseek(file, offsetof(store_header_t, version), SEEK_SET);
+        fwrite(&version, sizeof(version), 1, file);
+        fclose(file);
+    }
+
+    store_t store;
+    store_test_check(store_open(&store, STORE_TEST_PATH, STORE_BUDGET_DEFAULT), "store can not be reopened");
+    store_test_check(store.count == 1 && store_test_files(false) == 1, "segment of another version is kept");
+    store_test_check(store_test_missing(&store, 0), "tile of another version is found");
+    store_test_check(store_test_find(&store, STORE_TEST_TILES - 1, 0) && store_test_find(&store, STORE_TEST_ACROSS, 1),
+                     "tiles of the current version are lost");
+    store_close(&store);
+}
+
+static void store_test_shared(void) {
+    // A second store on the same directory finds what the first one appends to a segment it
+    // already mapped, and what it appends to a segment of its own
+    store_t first, second;
+    store_test_check(store_open(&first, STORE_TEST_PATH, STORE_BUDGET_DEFAULT), "first store can not be opened");
+    store_test_write(&first, 1000, 0);
+    store_test_check(store_open(&second, STORE_TEST_PATH, STORE_BUDGET_DEFAULT), "second store can not be opened");
+    store_test_check(store_test_find(&second, 1000, 0), "second store misses a tile written before it opened");
+    store_test_write(&first, 1001, 0);
+    store_test_check(store_test_find(&second, 1001, 0), "second store misses a tile appended since it opened");
+    store_test_write(&second, 1002, 0);
+    store_test_check(store_test_find(&second, 1002, 0), "second store misses its own tile");
+    store_close(&second);
+    store_close(&first);
+}
+
+static void store_test_budget(void) {
+    // The smallest budget keeps two segments, counting the files of every store in the directory
+    store_t store;
+    store_test_check(store_open(&store, STORE_TEST_PATH, 0), "store can not be opened");
+    store_test_check(store.limit == 2, "smallest budget does not keep two segments");
+    for (u32 x = 0; x < 2 * STORE_SEGMENT_TILES + 1; x++) {
+        store_test_write(&store, 2000 + x, 0);
+        if (store_test_files(false) > store.limit) {
+            store_test_check(false, "directory holds more segments than the budget");
+            break;
+        }
+    }
+    store_test_check(store_test_missing(&store, 2000) && store_test_missing(&store, 1000),
+                     "tiles of evicted segments are found");
+    store_test_check(store_test_find(&store, 2000 + 2 * STORE_SEGMENT_TILES, 0), "newest tile is lost");
+    store_close(&store);
+}
+
+int main(void) {
+    store_test_files(true);
+    store_test_reopen();
+    store_test_version();
+    store_test_shared();
+    store_test_budget();
+    store_test_files(true);
+    printf("[store_test] %u failures\n", store_test_failures);
+    return store_test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cpu.h"
+#include "refine.h"
+#include "trace.h"
+
+// Not a multiple of the tile size, so the last row and column of tiles are partial
+#define TRACE_TEST_WIDTH 200
+#define TRACE_TEST_HEIGHT 150
+
+typedef struct trace_test_view {
+    const char *name;
+    f64 center_x;
+    f64 center_y;
+    f64 center_x_low;
+    f64 center_y_low;
+    f64 scale;
+    u32 max_iterations;
+} trace_test_view_t;
+
+int main(void) {
+    // The whole set, a bulb whose interior runs into every edge of the image, a region close
+    // to the boundary and a view beyond double-double precision
+    static const trace_test_view_t views[] = {
+            {"shallow", -0.5, 0.0, 0.0, 0.0, 0.02, 256},
+            {"interior", -0.12, 0.76, 0.0, 0.0, 0.0008, 1000},
+            {"boundary", -0.7436438870371587, 0.1318259042053119, 0.0, 0.0, 1e-7, 4000},
+            {"perturbation", -0.74364374344752537, 0.13182574930062566, -2.3637447219426548e-18,
+             6.9695318357042824e-18, 1e-31, 20000},
+    };
+    static u32 expected[TRACE_TEST_WIDTH * TRACE_TEST_HEIGHT];
+    static u32 actual[TRACE_TEST_WIDTH * TRACE_TEST_HEIGHT];
+    perturb_t perturb;
+    perturb_create(&perturb);
+    refine_t refine;
+    refine_create(&refine);
+    refine_method(&refine, REFINE_METHOD_TRACE);
+    u32 failures = 0;
+    for (u32 i = 0; i < STACK_ARRAY_SIZE(views); i++) {
+        fractal_view_t view;
+        fractal_view_create_default(&view, TRACE_TEST_WIDTH, TRACE_TEST_HEIGHT);
+        view.center_x = views[i].center_x;
+        view.center_y = views[i].center_y;
+        view.center_x_low = views[i].center_x_low;
+        view.center_y_low = views[i].center_y_low;
+        view.scale = views[i].scale;
+        view.max_iterations = views[i].max_iterations;
+        kernel_stats_t stats;
+        fractal_cpu_render(&view, expected, NULL, &stats);
+        trace_render(NULL, &perturb, &view, actual, NULL, &stats);
+
+        u32 count = view.width * view.height;
+        u32 differences = 0;
+        for (u32 j = 0; j < count; j++) {
+            differences += expected[j] != actual[j];
+        }
+        if (differences > 0) {
+            fprintf(stderr, "[trace_test] %s view differs from fractal_cpu_render in %u of %u pixels\n",
+                    views[i].name, differences, count);
+            failures++;
+        }
+
+        // A trace that never fills anything would pass without testing the boundaries
+        if (stats.filled == 0) {
+            fprintf(stderr, "[trace_test] %s view filled no pixels\n", views[i].name);
+            failures++;
+        }
+
+        // The viewer goes through the refinement, which completes the view in a single step
+        refine_reset(&refine, &view);
+        refine_step(&refine, NULL);
+        bool equal = refine_complete(&refine);
+        for (u32 j = 0; j < count && equal; j++) {
+            equal = refine.iterations[j] == actual[j];
+        }
+        if (!equal) {
+            fprintf(stderr, "[trace_test] %s view is not completed by refine_step\n", views[i].name);
+            failures++;
+        }
+    }
+    refine_destroy(&refine);
+    perturb_destroy(&perturb);
+    printf("[trace_test] %u views, %u failures\n", (u32) STACK_ARRAY_SIZE(views), failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
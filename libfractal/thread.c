@@ -0,0 +1,324 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "math.h"
+#include "thread.h"
+
+#ifndef _WIN32
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// ===================================================================================
+// PLATFORM
+// ===================================================================================
+
+#ifdef _WIN32
+typedef DWORD thread_result_t;
+#define THREAD_CALL WINAPI
+#else
+typedef void *thread_result_t;
+#define THREAD_CALL
+#endif
+
+typedef thread_result_t(THREAD_CALL *thread_main_t)(void *argument);
+
+static void thread_create(thread_handle_t *self, thread_main_t main, void *argument) {
+#ifdef _WIN32
+    *self = CreateThread(NULL, 0, main, argument, 0, NULL);
+#else
+    pthread_create(self, NULL, main, argument);
+#endif
+}
+
+static void thread_join(thread_handle_t *self) {
+#ifdef _WIN32
+    WaitForSingleObject(*self, INFINITE);
+    CloseHandle(*self);
+#else
+    pthread_join(*self, NULL);
+#endif
+}
+
+static void thread_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static void thread_mutex_create(thread_mutex_t *self) {
+#ifdef _WIN32
+    InitializeSRWLock(self);
+#else
+    pthread_mutex_init(self, NULL);
+#endif
+}
+
+static void thread_mutex_destroy(thread_mutex_t *self) {
+#ifndef _WIN32
+    pthread_mutex_destroy(self);
+#endif
+}
+
+static void thread_mutex_lock(thread_mutex_t *self) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(self);
+#else
+    pthread_mutex_lock(self);
+#endif
+}
+
+static void thread_mutex_unlock(thread_mutex_t *self) {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(self);
+#else
+    pthread_mutex_unlock(self);
+#endif
+}
+
+static void thread_condition_create(thread_condition_t *self) {
+#ifdef _WIN32
+    InitializeConditionVariable(self);
+#else
+    pthread_cond_init(self, NULL);
+#endif
+}
+
+static void thread_condition_destroy(thread_condition_t *self) {
+#ifndef _WIN32
+    pthread_cond_destroy(self);
+#endif
+}
+
+static void thread_condition_wait(thread_condition_t *self, thread_mutex_t *mutex) {
+#ifdef _WIN32
+    SleepConditionVariableSRW(self, mutex, INFINITE, 0);
+#else
+    pthread_cond_wait(self, mutex);
+#endif
+}
+
+static void thread_condition_broadcast(thread_condition_t *self) {
+#ifdef _WIN32
+    WakeAllConditionVariable(self);
+#else
+    pthread_cond_broadcast(self);
+#endif
+}
+
+u32 thread_hardware_concurrency(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u32) info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32) count : 1;
+#endif
+}
+
+// ===================================================================================
+// WORK STEALING DEQUE
+// ===================================================================================
+
+static void thread_pool_deque_push(thread_pool_deque_t *self, thread_pool_range_t range) {
+    thread_mutex_lock(&self->mutex);
+    ASSERT(self->tail - self->head < THREAD_POOL_DEQUE_CAPACITY, "[thread] deque overflow\n");
+    self->ranges[self->tail % THREAD_POOL_DEQUE_CAPACITY] = range;
+    self->tail++;
+    thread_mutex_unlock(&self->mutex);
+}
+
+static bool thread_pool_deque_pop(thread_pool_deque_t *self, thread_pool_range_t *result) {
+    thread_mutex_lock(&self->mutex);
+    bool success = self->tail != self->head;
+    if (success) {
+        self->tail--;
+        *result = self->ranges[self->tail % THREAD_POOL_DEQUE_CAPACITY];
+    }
+    thread_mutex_unlock(&self->mutex);
+    return success;
+}
+
+static bool thread_pool_deque_steal(thread_pool_deque_t *self, thread_pool_range_t *result) {
+    thread_mutex_lock(&self->mutex);
+    bool success = self->tail != self->head;
+    if (success) {
+        *result = self->ranges[self->head % THREAD_POOL_DEQUE_CAPACITY];
+        self->head++;
+    }
+    thread_mutex_unlock(&self->mutex);
+    return success;
+}
+
+// ===================================================================================
+// THREAD POOL
+// ===================================================================================
+
+static bool thread_pool_next(thread_pool_t *self, u32 worker, thread_pool_range_t *result) {
+    if (thread_pool_deque_pop(&self->workers[worker].deque, result)) {
+        return true;
+    }
+    for (u32 i = 1; i < self->worker_count; i++) {
+        u32 victim = (worker + i) % self->worker_count;
+        if (thread_pool_deque_steal(&self->workers[victim].deque, result)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void thread_pool_work(thread_pool_t *self, u32 worker) {
+    thread_pool_deque_t *deque = &self->workers[worker].deque;
+    while (atomic_load(&self->remaining) > 0) {
+        thread_pool_range_t range;
+        if (!thread_pool_next(self, worker, &range)) {
+            // Everything is claimed, but a busy worker may still split a range it owns
+            thread_yield();
+            continue;
+        }
+
+        // Lazy binary splitting, the upper half is published for thieves and the
+        // deque never holds more than log2(count) ranges per worker
+        while (range.end - range.begin > 1) {
+            u32 middle = range.begin + (range.end - range.begin) / 2;
+            thread_pool_range_t upper = {middle, range.end};
+            thread_pool_deque_push(deque, upper);
+            range.end = middle;
+        }
+        self->task(self->user, range.begin, worker);
+        atomic_fetch_sub(&self->remaining, 1);
+    }
+}
+
+static thread_result_t THREAD_CALL thread_pool_main(void *argument) {
+    thread_pool_worker_t *worker = argument;
+    thread_pool_t *self = worker->pool;
+    u64 generation = 0;
+
+    thread_mutex_lock(&self->mutex);
+    for (;;) {
+        while (self->running && self->generation == generation) {
+            thread_condition_wait(&self->wake, &self->mutex);
+        }
+        if (!self->running) {
+            break;
+        }
+        generation = self->generation;
+        thread_mutex_unlock(&self->mutex);
+
+        thread_pool_work(self, worker->index);
+
+        thread_mutex_lock(&self->mutex);
+        if (--self->busy == 0) {
+            thread_condition_broadcast(&self->done);
+        }
+    }
+    thread_mutex_unlock(&self->mutex);
+    return 0;
+}
+
+void thread_pool_create(thread_pool_t *self, u32 workers) {
+    if (workers == 0) {
+        workers = thread_hardware_concurrency();
+    }
+    self->worker_count = (u32) s32_clamp((s32) workers, 1, THREAD_POOL_MAX_WORKERS);
+    self->task = NULL;
+    self->user = NULL;
+    self->generation = 0;
+    self->busy = 0;
+    self->running = true;
+    atomic_init(&self->remaining, 0);
+    thread_mutex_create(&self->mutex);
+    thread_condition_create(&self->wake);
+    thread_condition_create(&self->done);
+
+    for (u32 i = 0; i < self->worker_count; i++) {
+        thread_pool_worker_t *worker = &self->workers[i];
+        thread_mutex_create(&worker->deque.mutex);
+        worker->deque.head = 0;
+        worker->deque.tail = 0;
+        worker->pool = self;
+        worker->index = i;
+    }
+
+    // Worker zero is the thread that calls thread_pool_run
+    for (u32 i = 1; i < self->worker_count; i++) {
+        thread_create(&self->workers[i].handle, thread_pool_main, &self->workers[i]);
+    }
+}
+
+void thread_pool_destroy(thread_pool_t *self) {
+    thread_mutex_lock(&self->mutex);
+    self->running = false;
+    thread_condition_broadcast(&self->wake);
+    thread_mutex_unlock(&self->mutex);
+
+    for (u32 i = 1; i < self->worker_count; i++) {
+        thread_join(&self->workers[i].handle);
+    }
+    for (u32 i = 0; i < self->worker_count; i++) {
+        thread_mutex_destroy(&self->workers[i].deque.mutex);
+    }
+    thread_condition_destroy(&self->done);
+    thread_condition_destroy(&self->wake);
+    thread_mutex_destroy(&self->mutex);
+}
+
+void thread_pool_run(thread_pool_t *self, u32 count, thread_pool_task_t task, void *user) {
+    if (count == 0) {
+        return;
+    }
+
+    // Contiguous ranges keep neighbouring tasks on the same worker
+    for (u32 i = 0; i < self->worker_count; i++) {
+        thread_pool_range_t range = {(u32) ((u64) count * i / self->worker_count),
+                                     (u32) ((u64) count * (i + 1) / self->worker_count)};
+        if (range.begin < range.end) {
+            thread_pool_deque_push(&self->workers[i].deque, range);
+        }
+    }
+    atomic_store(&self->remaining, count);
+
+    thread_mutex_lock(&self->mutex);
+    self->task = task;
+    self->user = user;
+    self->busy = self->worker_count - 1;
+    self->generation++;
+    thread_condition_broadcast(&self->wake);
+    thread_mutex_unlock(&self->mutex);
+
+    thread_pool_work(self, 0);
+
+    thread_mutex_lock(&self->mutex);
+    while (self->busy > 0) {
+        thread_condition_wait(&self->done, &self->mutex);
+    }
+    thread_mutex_unlock(&self->mutex);
+}
@@ -0,0 +1,123 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_THREAD_H
+#define LIBFRACTAL_THREAD_H
+
+#include "types.h"
+
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef HANDLE thread_handle_t;
+typedef SRWLOCK thread_mutex_t;
+typedef CONDITION_VARIABLE thread_condition_t;
+#else
+#include <pthread.h>
+typedef pthread_t thread_handle_t;
+typedef pthread_mutex_t thread_mutex_t;
+typedef pthread_cond_t thread_condition_t;
+#endif
+
+#define THREAD_POOL_MAX_WORKERS 256
+#define THREAD_POOL_DEQUE_CAPACITY 64
+
+/**
+ * A task of the pool, called once for every index in [0, count)
+ */
+typedef void (*thread_pool_task_t)(void *user, u32 task, u32 worker);
+
+typedef struct thread_pool_range {
+    u32 begin;
+    u32 end;
+} thread_pool_range_t;
+
+/**
+ * Per-worker deque of task ranges, the owner pushes and pops at the tail, thieves
+ * take the oldest (and therefore largest) range from the head
+ */
+typedef struct thread_pool_deque {
+    thread_mutex_t mutex;
+    thread_pool_range_t ranges[THREAD_POOL_DEQUE_CAPACITY];
+    u32 head;
+    u32 tail;
+} thread_pool_deque_t;
+
+typedef struct thread_pool_worker {
+    thread_pool_deque_t deque;
+    thread_handle_t handle;
+    struct thread_pool *pool;
+    u32 index;
+} thread_pool_worker_t;
+
+typedef struct thread_pool {
+    thread_pool_worker_t workers[THREAD_POOL_MAX_WORKERS];
+    u32 worker_count;
+    thread_mutex_t mutex;
+    thread_condition_t wake;
+    thread_condition_t done;
+    thread_pool_task_t task;
+    void *user;
+    u64 generation;
+    u32 busy;
+    atomic_uint remaining;
+    bool running;
+} thread_pool_t;
+
+/**
+ * Returns the number of hardware threads of this machine
+ *
+ * @return thread count
+ */
+u32 thread_hardware_concurrency(void);
+
+/**
+ * Creates a new thread pool, the calling thread counts as the first worker
+ *
+ * @param self pool handle
+ * @param workers number of workers, 0 uses one worker per hardware thread
+ */
+void thread_pool_create(thread_pool_t *self, u32 workers);
+
+/**
+ * Stops and joins all workers of the pool
+ *
+ * @param self pool handle
+ */
+void thread_pool_destroy(thread_pool_t *self);
+
+/**
+ * Runs count tasks on the pool and blocks until all of them are finished. The tasks are
+ * split into contiguous ranges per worker, idle workers steal from the others.
+ *
+ * @param self pool handle
+ * @param count number of tasks
+ * @param task task function
+ * @param user user pointer passed to the task function
+ */
+void thread_pool_run(thread_pool_t *self, u32 count, thread_pool_task_t task, void *user);
+
+#endif// LIBFRACTAL_THREAD_H
@@ -0,0 +1,237 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "trace.h"
+#include "cpu.h"
+#include "math.h"
+
+#include <string.h>
+
+// Tiles that are handed to the pool, each one is traced on its own
+#define TRACE_TILE 64
+
+// Pixel states of a tile
+#define TRACE_EVALUATED 1
+#define TRACE_QUEUED 2
+
+typedef struct trace_job {
+    const fractal_view_t *view;
+    const kernel_t *kernel;
+    fractal_precision_t precision;
+    const perturb_t *perturb;
+    u32 *iterations;
+    f32vec4_t *colors;
+    u32 tiles_x;
+    atomic_uint rejected;
+    atomic_uint periodic;
+    atomic_uint attracted;
+    atomic_uint filled;
+} trace_job_t;
+
+typedef struct trace_tile {
+    const trace_job_t *job;
+    u32 x0;
+    u32 y0;
+    u32 x1;
+    u32 y1;
+    u8 state[TRACE_TILE * TRACE_TILE];
+    u32 queue[2][TRACE_TILE * TRACE_TILE];
+    u32 pending[TRACE_TILE * TRACE_TILE];
+    u32 pending_count;
+    kernel_stats_t stats;
+} trace_tile_t;
+
+static u8 *trace_state(trace_tile_t *self, u32 x, u32 y) {
+    return self->state + (y - self->y0) * TRACE_TILE + (x - self->x0);
+}
+
+static void trace_request(trace_tile_t *self, u32 x, u32 y) {
+    u8 *state = trace_state(self, x, y);
+    if (!(*state & TRACE_EVALUATED)) {
+        *state |= TRACE_EVALUATED;
+        self->pending[self->pending_count++] = y * self->job->view->width + x;
+    }
+}
+
+static void trace_flush(trace_tile_t *self) {
+    const trace_job_t *job = self->job;
+    if (job->precision == FRACTAL_PRECISION_PERTURBATION) {
+        perturb_render_pixels(job->perturb, job->view, self->pending, self->pending_count, job->iterations,
+                              &self->stats);
+    } else {
+        fractal_cpu_render_pixels(job->view, job->kernel, job->precision, self->pending, self->pending_count,
+                                  job->iterations, &self->stats);
+    }
+    self->pending_count = 0;
+}
+
+static u32 trace_enqueue(trace_tile_t *self, u32 x, u32 y, u32 *queue, u32 count) {
+    u8 *state = trace_state(self, x, y);
+    if (!(*state & TRACE_QUEUED)) {
+        *state |= TRACE_QUEUED;
+        queue[count++] = y * self->job->view->width + x;
+    }
+    return count;
+}
+
+static void trace_tile(trace_tile_t *self) {
+    u32 width = self->job->view->width;
+    const u32 *iterations = self->job->iterations;
+
+    // The border of the tile seeds the trace
+    u32 *queue = self->queue[0];
+    u32 count = 0;
+    for (u32 x = self->x0; x < self->x1; x++) {
+        count = trace_enqueue(self, x, self->y0, queue, count);
+        count = trace_enqueue(self, x, self->y1 - 1, queue, count);
+    }
+    for (u32 y = self->y0; y < self->y1; y++) {
+        count = trace_enqueue(self, self->x0, y, queue, count);
+        count = trace_enqueue(self, self->x1 - 1, y, queue, count);
+    }
+
+    // The queue is worked off in waves, every wave evaluates its pixels together with their
+    // direct neighbours in one batch, edges then queue all eight neighbours for the next wave
+    for (u32 wave = 0; count > 0; wave ^= 1) {
+        queue = self->queue[wave];
+        for (u32 i = 0; i < count; i++) {
+            u32 x = queue[i] % width;
+            u32 y = queue[i] / width;
+            trace_request(self, x, y);
+            if (x > self->x0) {
+                trace_request(self, x - 1, y);
+            }
+            if (x + 1 < self->x1) {
+                trace_request(self, x + 1, y);
+            }
+            if (y > self->y0) {
+                trace_request(self, x, y - 1);
+            }
+            if (y + 1 < self->y1) {
+                trace_request(self, x, y + 1);
+            }
+        }
+        trace_flush(self);
+
+        u32 *next = self->queue[wave ^ 1];
+        u32 next_count = 0;
+        for (u32 i = 0; i < count; i++) {
+            u32 x = queue[i] % width;
+            u32 y = queue[i] / width;
+            u32 value = iterations[queue[i]];
+            bool edge = (x > self->x0 && iterations[queue[i] - 1] != value) ||
+                        (x + 1 < self->x1 && iterations[queue[i] + 1] != value) ||
+                        (y > self->y0 && iterations[queue[i] - width] != value) ||
+                        (y + 1 < self->y1 && iterations[queue[i] + width] != value);
+            if (!edge) {
+                continue;
+            }
+            u32 nx0 = x > self->x0 ? x - 1 : x;
+            u32 ny0 = y > self->y0 ? y - 1 : y;
+            u32 nx1 = x + 1 < self->x1 ? x + 1 : x;
+            u32 ny1 = y + 1 < self->y1 ? y + 1 : y;
+            for (u32 ny = ny0; ny <= ny1; ny++) {
+                for (u32 nx = nx0; nx <= nx1; nx++) {
+                    next_count = trace_enqueue(self, nx, ny, next, next_count);
+                }
+            }
+        }
+        count = next_count;
+    }
+
+    // Everything that was not reached lies within a boundary of a single count, the
+    // left border of the tile is always evaluated so every row starts out known
+    u32 *target = self->job->iterations;
+    for (u32 y = self->y0; y < self->y1; y++) {
+        for (u32 x = self->x0 + 1; x < self->x1; x++) {
+            if (!(*trace_state(self, x, y) & TRACE_EVALUATED)) {
+                target[y * width + x] = target[y * width + x - 1];
+                self->stats.filled++;
+            }
+        }
+    }
+}
+
+static void trace_render_tile(void *user, u32 tile, u32 worker) {
+    trace_job_t *job = user;
+    const fractal_view_t *view = job->view;
+    trace_tile_t state;
+    state.job = job;
+    state.x0 = (tile % job->tiles_x) * TRACE_TILE;
+    state.y0 = (tile / job->tiles_x) * TRACE_TILE;
+    state.x1 = (u32) s32_min((s32) (state.x0 + TRACE_TILE), (s32) view->width);
+    state.y1 = (u32) s32_min((s32) (state.y0 + TRACE_TILE), (s32) view->height);
+    state.pending_count = 0;
+    memset(state.state, 0, sizeof(state.state));
+    memset(&state.stats, 0, sizeof(state.stats));
+    trace_tile(&state);
+
+    if (job->colors) {
+        for (u32 y = state.y0; y < state.y1; y++) {
+            for (u32 x = state.x0; x < state.x1; x++) {
+                u32 index = y * view->width + x;
+                fractal_cpu_color(job->iterations[index], view->max_iterations, job->colors + index);
+            }
+        }
+    }
+    atomic_fetch_add(&job->rejected, state.stats.rejected);
+    atomic_fetch_add(&job->periodic, state.stats.periodic);
+    atomic_fetch_add(&job->attracted, state.stats.attracted);
+    atomic_fetch_add(&job->filled, state.stats.filled);
+}
+
+void trace_render(thread_pool_t *pool, perturb_t *perturb, const fractal_view_t *view, u32 *iterations,
+                  f32vec4_t *colors, kernel_stats_t *stats) {
+    // The reference orbit is computed once up front, the tiles only read it
+    trace_job_t job;
+    job.view = view;
+    job.kernel = kernel_select();
+    job.precision = fractal_view_precision(view);
+    job.perturb = perturb;
+    if (job.precision == FRACTAL_PRECISION_PERTURBATION) {
+        perturb_center_view(perturb, view);
+        perturb_prepare(perturb, view);
+    }
+    job.iterations = iterations;
+    job.colors = colors;
+    job.tiles_x = (view->width + TRACE_TILE - 1) / TRACE_TILE;
+    atomic_init(&job.rejected, 0);
+    atomic_init(&job.periodic, 0);
+    atomic_init(&job.attracted, 0);
+    atomic_init(&job.filled, 0);
+    u32 tiles = job.tiles_x * ((view->height + TRACE_TILE - 1) / TRACE_TILE);
+    if (pool) {
+        thread_pool_run(pool, tiles, trace_render_tile, &job);
+    } else {
+        for (u32 tile = 0; tile < tiles; tile++) {
+            trace_render_tile(&job, tile, 0);
+        }
+    }
+    if (stats) {
+        stats->rejected = atomic_load(&job.rejected);
+        stats->periodic = atomic_load(&job.periodic);
+        stats->attracted = atomic_load(&job.attracted);
+        stats->filled = atomic_load(&job.filled);
+    }
+}
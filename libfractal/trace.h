@@ -0,0 +1,54 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_TRACE_H
+#define LIBFRACTAL_TRACE_H
+
+#include "kernel.h"
+#include "perturb.h"
+#include "thread.h"
+#include "types.h"
+#include "view.h"
+
+/**
+ * Renders the view by tracing the boundaries of equal-iteration regions. Starting from
+ * the border of each tile, every evaluated pixel is compared with its neighbours, only
+ * pixels next to a different count spread the evaluation to their neighbours. Whatever
+ * is enclosed by such a boundary is never evaluated and filled from the left instead.
+ * The border of every tile is always evaluated, tiles are therefore closed regions of
+ * their own and rendered in parallel. The image matches fractal_cpu_render unless a
+ * detail is enclosed by a boundary of a single count without touching it. Perturbation
+ * views share the reference orbit of the perturbation renderer, see subdivide_render.
+ *
+ * @param pool pool handle, may be NULL to render on the calling thread
+ * @param perturb perturbation handle, only used for views beyond double-double precision
+ * @param view view handle
+ * @param iterations iteration count per pixel
+ * @param colors color per pixel, may be NULL if only iterations are needed
+ * @param stats counters of the frame, filled holds the pixels that were never evaluated, may be NULL
+ */
+void trace_render(thread_pool_t *pool, perturb_t *perturb, const fractal_view_t *view, u32 *iterations,
+                  f32vec4_t *colors, kernel_stats_t *stats);
+
+#endif// LIBFRACTAL_TRACE_H
@@ -92,6 +92,20 @@ typedef struct f32vec4 {
     f32 w;
 } f32vec4_t;
 
+typedef struct f64vec2 {
+    f64 x;
+    f64 y;
+} f64vec2_t;
+
+/**
+ * Double-double number, the unevaluated sum hi + lo with |lo| <= ulp(hi) / 2,
+ * which gives roughly 106 bits of mantissa
+ */
+typedef struct ddouble {
+    f64 hi;
+    f64 lo;
+} ddouble_t;
+
 typedef struct f32mat4 {
     f32vec4_t value[4];
 } f32mat4_t;
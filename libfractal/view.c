@@ -0,0 +1,277 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <float.h>
+#include <math.h>
+
+#include "math.h"
+#include "view.h"
+
+// Vertical extent of the default view
+#define FRACTAL_VIEW_EXTENT 2.24
+
+// Growth of the iteration limit per decade of zoom
+#define FRACTAL_ITERATIONS_GROWTH 1.25
+
+// Fraction of a pixel up to which two centers count as a whole number of pixels apart
+#define FRACTAL_VIEW_OFFSET_TOLERANCE 1e-3
+
+// Largest distance of the center from the origin in pixels for which lattice positions fit in 64 bits
+#define FRACTAL_VIEW_LATTICE_LIMIT 0x1p61
+
+// ===================================================================================
+// VIEW
+// ===================================================================================
+
+void fractal_view_create_default(fractal_view_t *self, u32 width, u32 height) {
+    // Mirrors the orthogonal projection of fractal_pipeline_submit, the vertical
+    // extent is [-1.12, 1.12] and the horizontal extent is centered the same way
+    f64 ratio = (f64) width / (f64) height;
+    self->center_x = 0.5 * (-2.0 + 0.47) * ratio;
+    self->center_y = 0.0;
+    self->center_x_low = 0.0;
+    self->center_y_low = 0.0;
+    self->scale = FRACTAL_VIEW_EXTENT / (f64) height;
+    self->width = width;
+    self->height = height;
+    self->max_iterations = FRACTAL_ITERATIONS_MINIMUM;
+    self->periodicity = false;
+    self->attraction = false;
+}
+
+void fractal_view_pixel(const fractal_view_t *self, u32 x, u32 y, f64 *result_x, f64 *result_y) {
+    *result_x = self->center_x + ((f64) x + 0.5 - 0.5 * (f64) self->width) * self->scale;
+    *result_y = self->center_y + ((f64) y + 0.5 - 0.5 * (f64) self->height) * self->scale;
+}
+
+void fractal_view_resize(fractal_view_t *self, u32 width, u32 height) {
+    self->scale *= (f64) self->height / (f64) height;
+    self->width = width;
+    self->height = height;
+}
+
+void fractal_view_pixel_ddouble(const fractal_view_t *self, u32 x, u32 y, ddouble_t *result_x, ddouble_t *result_y) {
+    // The pixel offsets are exact in double precision, their product with the scale is exact in double-double
+    ddouble_t center_x = {self->center_x, self->center_x_low};
+    ddouble_t center_y = {self->center_y, self->center_y_low};
+    f64 offset_x = (f64) x + 0.5 - 0.5 * (f64) self->width;
+    f64 offset_y = (f64) y + 0.5 - 0.5 * (f64) self->height;
+    *result_x = ddouble_add(center_x, ddouble_product(offset_x, self->scale));
+    *result_y = ddouble_add(center_y, ddouble_product(offset_y, self->scale));
+}
+
+static void fractal_view_move(fractal_view_t *self, f64 offset_x, f64 offset_y) {
+    ddouble_t center_x = {self->center_x, self->center_x_low};
+    ddouble_t center_y = {self->center_y, self->center_y_low};
+    center_x = ddouble_add(center_x, ddouble_product(offset_x, self->scale));
+    center_y = ddouble_add(center_y, ddouble_product(offset_y, self->scale));
+    self->center_x = center_x.hi;
+    self->center_y = center_y.hi;
+    self->center_x_low = center_x.lo;
+    self->center_y_low = center_y.lo;
+}
+
+void fractal_view_zoom(fractal_view_t *self, f64 x, f64 y, f64 factor) {
+    // The center is moved in double-double so that deep views can still be navigated
+    f64 offset_x = x - 0.5 * (f64) self->width;
+    f64 offset_y = y - 0.5 * (f64) self->height;
+    fractal_view_move(self, offset_x, offset_y);
+    self->scale /= factor;
+    fractal_view_move(self, -offset_x, -offset_y);
+}
+
+static f64 fractal_view_origin(f64 center, f64 center_low, f64 scale, u32 size, s64 *result) {
+    // Position of pixel 0 in units of the scale, split into an integer and the remaining fraction.
+    // Both parts of the center are divided exactly by a power of two scale and rounded separately
+    f64 high = center / scale;
+    f64 low = center_low / scale;
+    f64 high_integer = round(high);
+    f64 low_integer = round(low);
+    f64 fraction = (high - high_integer) + (low - low_integer) + 0.5 - 0.5 * (f64) size;
+    f64 fraction_integer = round(fraction);
+    *result = (s64) high_integer + (s64) low_integer + (s64) fraction_integer;
+    return fraction - fraction_integer;
+}
+
+void fractal_view_zoom_aligned(fractal_view_t *self, f64 x, f64 y, bool in) {
+    // Zooming in keeps pixel (x, y) of self at pixel (x & ~1, y & ~1), every even pixel of
+    // the result is a pixel of self. Zooming out keeps pixel (x, y) in place, every pixel of
+    // the result that lies within self is a pixel of self. See fractal_view_offset
+    f64 anchor_x = fmin(fmax(floor(x), 0.0), (f64) self->width - 1.0);
+    f64 anchor_y = fmin(fmax(floor(y), 0.0), (f64) self->height - 1.0);
+    if (in) {
+        f64 even_x = 2.0 * floor(0.5 * anchor_x);
+        f64 even_y = 2.0 * floor(0.5 * anchor_y);
+        fractal_view_move(self, anchor_x - 0.5 * even_x + 0.25 - 0.25 * (f64) self->width,
+                          anchor_y - 0.5 * even_y + 0.25 - 0.25 * (f64) self->height);
+        self->scale *= 0.5;
+    } else {
+        // The kept pixels have to be the even ones on the lattice of fractal_view_lattice
+        s64 origin_x, origin_y;
+        fractal_view_origin(self->center_x, self->center_x_low, self->scale, self->width, &origin_x);
+        fractal_view_origin(self->center_y, self->center_y_low, self->scale, self->height, &origin_y);
+        if ((origin_x + (s64) anchor_x) & 1) {
+            anchor_x += anchor_x > 0.0 ? -1.0 : 1.0;
+        }
+        if ((origin_y + (s64) anchor_y) & 1) {
+            anchor_y += anchor_y > 0.0 ? -1.0 : 1.0;
+        }
+        fractal_view_move(self, 0.5 * (f64) self->width - 0.5 - anchor_x,
+                          0.5 * (f64) self->height - 0.5 - anchor_y);
+        self->scale *= 2.0;
+    }
+}
+
+void fractal_view_pan(fractal_view_t *self, f64 dx, f64 dy) {
+    fractal_view_move(self, -dx, -dy);
+}
+
+bool fractal_view_equal(const fractal_view_t *self, const fractal_view_t *other) {
+    return self->center_x == other->center_x && self->center_y == other->center_y &&
+           self->center_x_low == other->center_x_low && self->center_y_low == other->center_y_low &&
+           self->scale == other->scale && self->width == other->width && self->height == other->height &&
+           self->max_iterations == other->max_iterations && self->periodicity == other->periodicity &&
+           self->attraction == other->attraction;
+}
+
+bool fractal_view_offset(const fractal_view_t *self, const fractal_view_t *other, s32 *result_x, s32 *result_y) {
+    if (self->width != other->width || self->height != other->height ||
+        self->max_iterations != other->max_iterations || self->periodicity != other->periodicity ||
+        self->attraction != other->attraction) {
+        return false;
+    }
+
+    // The difference of the centers is taken in double-double, deep views are panned in steps
+    // far below the precision of the leading parts. Pixel x of other lies at
+    // ratio (x + 1/2 - width/2) + distance + width/2 - 1/2 in pixels of self
+    f64 ratio = other->scale / self->scale;
+    ddouble_t distance_x = ddouble_sub((ddouble_t) {other->center_x, other->center_x_low},
+                                       (ddouble_t) {self->center_x, self->center_x_low});
+    ddouble_t distance_y = ddouble_sub((ddouble_t) {other->center_y, other->center_y_low},
+                                       (ddouble_t) {self->center_y, self->center_y_low});
+    f64 offset_x = (distance_x.hi + distance_x.lo) / self->scale + (ratio - 1.0) * (0.5 - 0.5 * (f64) self->width);
+    f64 offset_y = (distance_y.hi + distance_y.lo) / self->scale + (ratio - 1.0) * (0.5 - 0.5 * (f64) self->height);
+    f64 pixels_x = round(offset_x);
+    f64 pixels_y = round(offset_y);
+    if (fabs(offset_x - pixels_x) > FRACTAL_VIEW_OFFSET_TOLERANCE ||
+        fabs(offset_y - pixels_y) > FRACTAL_VIEW_OFFSET_TOLERANCE || fabs(pixels_x) > 2.0 * (f64) self->width ||
+        fabs(pixels_y) > 2.0 * (f64) self->height) {
+        return false;
+    }
+    *result_x = (s32) pixels_x;
+    *result_y = (s32) pixels_y;
+    return true;
+}
+
+bool fractal_view_lattice(const fractal_view_t *self, s32 *level, s64 *origin_x, s64 *origin_y) {
+    // Scales of 2^-level have a mantissa of exactly one half
+    s32 exponent;
+    if (frexp(self->scale, &exponent) != 0.5 || fabs(self->center_x) > FRACTAL_VIEW_LATTICE_LIMIT * self->scale ||
+        fabs(self->center_y) > FRACTAL_VIEW_LATTICE_LIMIT * self->scale) {
+        return false;
+    }
+    f64 fraction_x = fractal_view_origin(self->center_x, self->center_x_low, self->scale, self->width, origin_x);
+    f64 fraction_y = fractal_view_origin(self->center_y, self->center_y_low, self->scale, self->height, origin_y);
+    *level = 1 - exponent;
+    return fabs(fraction_x) <= FRACTAL_VIEW_OFFSET_TOLERANCE && fabs(fraction_y) <= FRACTAL_VIEW_OFFSET_TOLERANCE;
+}
+
+void fractal_view_snap(fractal_view_t *self) {
+    self->scale = exp2(round(log2(self->scale)));
+    s64 origin_x, origin_y;
+    f64 fraction_x = fractal_view_origin(self->center_x, self->center_x_low, self->scale, self->width, &origin_x);
+    f64 fraction_y = fractal_view_origin(self->center_y, self->center_y_low, self->scale, self->height, &origin_y);
+    fractal_view_move(self, -fraction_x, -fraction_y);
+}
+
+// ===================================================================================
+// PRECISION
+// ===================================================================================
+
+fractal_precision_t fractal_view_precision(const fractal_view_t *self) {
+    // The largest magnitude any coordinate reaches, z itself grows up to 2 before escaping
+    f64 extent_x = fabs(self->center_x) + 0.5 * (f64) self->width * self->scale;
+    f64 extent_y = fabs(self->center_y) + 0.5 * (f64) self->height * self->scale;
+    f64 magnitude = fmax(2.0, fmax(extent_x, extent_y));
+    if (self->scale > FRACTAL_PRECISION_MARGIN * FLT_EPSILON * magnitude) {
+        return FRACTAL_PRECISION_F32;
+    }
+    if (self->scale > FRACTAL_PRECISION_MARGIN * DBL_EPSILON * magnitude) {
+        return FRACTAL_PRECISION_F64;
+    }
+    if (self->scale > FRACTAL_PRECISION_MARGIN * DDOUBLE_EPSILON * magnitude) {
+        return FRACTAL_PRECISION_DDOUBLE;
+    }
+    return FRACTAL_PRECISION_PERTURBATION;
+}
+
+// ===================================================================================
+// ITERATIONS
+// ===================================================================================
+
+u32 fractal_view_depth_iterations(const fractal_view_t *self) {
+    f64 zoom = FRACTAL_VIEW_EXTENT / ((f64) self->height * self->scale);
+    f64 decades = fmax(0.0, log10(zoom));
+    f64 limit = FRACTAL_ITERATIONS_MINIMUM * pow(1.0 + decades, FRACTAL_ITERATIONS_GROWTH);
+    return (u32) fmin(limit, FRACTAL_ITERATIONS_MAXIMUM);
+}
+
+u32 fractal_view_adapt_iterations(const fractal_view_t *self, const u32 *iterations, f64 threshold) {
+    u32 limit = self->max_iterations;
+    u32 count = self->width * self->height;
+    if (count == 0 || limit < 2) {
+        return limit;
+    }
+
+    // Histogram of the escaped pixels over the octaves of the limit, octave k counts
+    // the escape counts in [limit / 2^(k + 1), limit / 2^k)
+    u32 octaves[32] = {0};
+    for (u32 i = 0; i < count; i++) {
+        if (iterations[i] < limit) {
+            u32 octave = 0;
+            while (octave < 31 && iterations[i] < limit >> (octave + 1)) {
+                octave++;
+            }
+            octaves[octave]++;
+        }
+    }
+
+    u32 minimum = fractal_view_depth_iterations(self);
+    u32 undecided = (u32) (threshold * (f64) count);
+    if (octaves[0] > undecided) {
+        limit = limit <= FRACTAL_ITERATIONS_MAXIMUM / 2 ? 2 * limit : FRACTAL_ITERATIONS_MAXIMUM;
+        return limit > minimum ? limit : minimum;
+    }
+
+    // Halving the limit turns everything above the new limit into undecided pixels
+    u32 above = octaves[0];
+    for (u32 octave = 1; octave < 32 && limit / 2 >= minimum; octave++) {
+        above += octaves[octave];
+        if (above > undecided) {
+            break;
+        }
+        limit /= 2;
+    }
+    return limit > minimum ? limit : minimum;
+}
@@ -0,0 +1,225 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023 Elias Engelbert Plank
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIBFRACTAL_VIEW_H
+#define LIBFRACTAL_VIEW_H
+
+#include "types.h"
+
+/**
+ * A view of the complex plane, scale is the distance between two pixels. The
+ * exact center is center + center_low, the low order parts only matter for
+ * views that are too deep for double precision. Periodicity checking and the attraction
+ * test find interior points that are not rejected up front, they only pay off at high
+ * iteration limits.
+ */
+typedef struct fractal_view {
+    f64 center_x;
+    f64 center_y;
+    f64 center_x_low;
+    f64 center_y_low;
+    f64 scale;
+    u32 width;
+    u32 height;
+    u32 max_iterations;
+    bool periodicity;
+    bool attraction;
+} fractal_view_t;
+
+/**
+ * Creates the default view, which shows the same region of the plane as the
+ * gpu pipeline does without any user interaction
+ *
+ * @param self view handle
+ * @param width width of the view in pixels
+ * @param height height of the view in pixels
+ */
+void fractal_view_create_default(fractal_view_t *self, u32 width, u32 height);
+
+/**
+ * Computes the point in the complex plane that is sampled by the center of the
+ * specified pixel, row zero is the bottom row (as with gl_FragCoord)
+ *
+ * @param self view handle
+ * @param x pixel column
+ * @param y pixel row
+ * @param result_x pointer to the real part of the point
+ * @param result_y pointer to the imaginary part of the point
+ */
+void fractal_view_pixel(const fractal_view_t *self, u32 x, u32 y, f64 *result_x, f64 *result_y);
+
+/**
+ * Computes the point sampled by the specified pixel in double-double precision,
+ * this includes the low order parts of the center
+ *
+ * @param self view handle
+ * @param x pixel column
+ * @param y pixel row
+ * @param result_x pointer to the real part of the point
+ * @param result_y pointer to the imaginary part of the point
+ */
+void fractal_view_pixel_ddouble(const fractal_view_t *self, u32 x, u32 y, ddouble_t *result_x, ddouble_t *result_y);
+
+/**
+ * Changes the size of the view in pixels, center and vertical extent are kept
+ *
+ * @param self view handle
+ * @param width new width in pixels
+ * @param height new height in pixels
+ */
+void fractal_view_resize(fractal_view_t *self, u32 width, u32 height);
+
+/**
+ * Zooms the view while the point under the specified pixel stays in place
+ *
+ * @param self view handle
+ * @param x pixel column, may be fractional
+ * @param y pixel row, may be fractional
+ * @param factor zoom factor, values greater than one zoom in
+ */
+void fractal_view_zoom(fractal_view_t *self, f64 x, f64 y, f64 factor);
+
+/**
+ * Zooms in or out by a factor of two around the specified pixel, snapped to the pixel lattice
+ * so that the samples of the view can be reused, see fractal_view_offset
+ *
+ * @param self view handle
+ * @param x pixel column, may be fractional
+ * @param y pixel row, may be fractional
+ * @param in whether to zoom in, otherwise the view zooms out
+ */
+void fractal_view_zoom_aligned(fractal_view_t *self, f64 x, f64 y, bool in);
+
+/**
+ * Moves the view by the specified amount of pixels, the content follows the offset
+ *
+ * @param self view handle
+ * @param dx horizontal offset in pixels
+ * @param dy vertical offset in pixels
+ */
+void fractal_view_pan(fractal_view_t *self, f64 dx, f64 dy);
+
+/**
+ * Checks whether both views sample exactly the same points with the same settings
+ *
+ * @param self view handle
+ * @param other view handle
+ * @return bool
+ */
+bool fractal_view_equal(const fractal_view_t *self, const fractal_view_t *other);
+
+/**
+ * Checks whether the pixel lattice of other is aligned to the one of self, pixel (x, y) of
+ * other then shows the point of pixel (ratio x + result_x, ratio y + result_y) of self where
+ * ratio is other->scale / self->scale. With a ratio of one, other is self panned by whole pixels.
+ *
+ * @param self view handle
+ * @param other view handle
+ * @param result_x pointer to the resulting horizontal offset in pixels
+ * @param result_y pointer to the resulting vertical offset in pixels
+ * @return false if the views differ in anything else or by a fraction of a pixel
+ */
+bool fractal_view_offset(const fractal_view_t *self, const fractal_view_t *other, s32 *result_x, s32 *result_y);
+
+/**
+ * Checks whether the view lies on the global lattice of its zoom level. Level l has a scale of
+ * 2^-l and samples the points (i 2^-l, j 2^-l) for all integers i and j, so that every lattice
+ * contains the one of the level above. Pixel (x, y) of the view then samples lattice point
+ * (origin_x + x, origin_y + y).
+ *
+ * @param self view handle
+ * @param level pointer to the resulting zoom level
+ * @param origin_x pointer to the resulting lattice column of pixel 0
+ * @param origin_y pointer to the resulting lattice row of pixel 0
+ * @return bool
+ */
+bool fractal_view_lattice(const fractal_view_t *self, s32 *level, s64 *origin_x, s64 *origin_y);
+
+/**
+ * Rounds the scale to the nearest power of two and moves the view by less than a pixel onto
+ * the global lattice, see fractal_view_lattice
+ *
+ * @param self view handle
+ */
+void fractal_view_snap(fractal_view_t *self);
+
+typedef enum fractal_precision {
+    FRACTAL_PRECISION_F32 = 0, FRACTAL_PRECISION_F64, FRACTAL_PRECISION_DDOUBLE, FRACTAL_PRECISION_PERTURBATION
+} fractal_precision_t;
+
+/**
+ * Epsilon of a double-double, 2^-104
+ */
+#define DDOUBLE_EPSILON 4.93038065763132e-32
+
+/**
+ * Pixels have to be at least this many units in the last place apart, otherwise
+ * neighbouring pixels round to the same point and the image turns into blocks
+ */
+#define FRACTAL_PRECISION_MARGIN 16.0
+
+/**
+ * Determines the cheapest precision whose epsilon still resolves the pixel spacing of the view,
+ * views beyond double-double precision have to be rendered with perturb_render
+ *
+ * @param self view handle
+ * @return precision
+ */
+fractal_precision_t fractal_view_precision(const fractal_view_t *self);
+
+/**
+ * Bounds of the automatic iteration limit, the lower one is the limit of the default view
+ */
+#define FRACTAL_ITERATIONS_MINIMUM 50
+#define FRACTAL_ITERATIONS_MAXIMUM (1u << 20)
+
+/**
+ * Fraction of the pixels that may be undecided before the iteration limit is raised
+ */
+#define FRACTAL_ITERATIONS_THRESHOLD 0.001
+
+/**
+ * Estimates the iteration limit the view needs from its zoom depth alone, deeper views
+ * need more iterations to resolve the boundary
+ *
+ * @param self view handle
+ * @return iteration limit
+ */
+u32 fractal_view_depth_iterations(const fractal_view_t *self);
+
+/**
+ * Derives the iteration limit for the next frame from the escape counts of a rendered frame.
+ * Pixels escaping in the upper half of the range estimate how many pixels are still undecided
+ * at the limit, the limit is doubled while they exceed the threshold. It is halved as long
+ * as the pixels that would become undecided stay below the threshold, but never below
+ * fractal_view_depth_iterations.
+ *
+ * @param self view the frame was rendered with
+ * @param iterations iteration count per pixel of the frame
+ * @param threshold fraction of undecided pixels, e.g. FRACTAL_ITERATIONS_THRESHOLD
+ * @return iteration limit
+ */
+u32 fractal_view_adapt_iterations(const fractal_view_t *self, const u32 *iterations, f64 threshold);
+
+#endif// LIBFRACTAL_VIEW_H
@@ -25,6 +25,22 @@
 #include <libfractal/display.h>
 #include <libfractal/gpu.h>
 #include <libfractal/fractal.h>
+#include <libfractal/math.h>
+#include <libfractal/thread.h>
+#include <libfractal/view.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Zoom factor per scroll wheel step, steps add up to zooms by a factor of two
+#define ZOOM_STEP 1.25
+
+// Environment variable that selects the renderer: cpu refines on the cpu and is the default,
+// subdivide and trace complete every view on the cpu with Mariani-Silver subdivision or by
+// tracing boundaries, gpu renders with the fragment shaders and distance with the distance shader
+#define RENDERER_ENVIRONMENT "FRACTAL_RENDERER"
 
 int main(int argc, char **argv) {
     display_t display;
@@ -33,13 +49,78 @@ int main(int argc, char **argv) {
     fractal_pipeline_t pipeline;
     fractal_pipeline_create(&pipeline);
 
+    const char *renderer = getenv(RENDERER_ENVIRONMENT);
+    bool gpu = false;
+    if (renderer && (strcmp(renderer, "gpu") == 0 || strcmp(renderer, "distance") == 0)) {
+        fractal_pipeline_distance(&pipeline, strcmp(renderer, "distance") == 0);
+        gpu = true;
+    } else if (renderer && strcmp(renderer, "subdivide") == 0) {
+        refine_method(&pipeline.refine, REFINE_METHOD_SUBDIVIDE);
+    } else if (renderer && strcmp(renderer, "trace") == 0) {
+        refine_method(&pipeline.refine, REFINE_METHOD_TRACE);
+    } else if (renderer && *renderer && strcmp(renderer, "cpu") != 0) {
+        fprintf(stderr, "[mandelbrot] unknown renderer %s, using cpu\n", renderer);
+    }
+
+    fractal_view_t view;
+    fractal_view_create_default(&view, display.width, display.height);
+    fractal_view_snap(&view);
+
+    // The pool is too large for the stack
+    static thread_pool_t pool;
+    thread_pool_create(&pool, 0);
+
+    // The iteration limit follows the zoom depth and is adapted to every completed frame
+    bool refining = true;
+
+    // Pans are rounded to whole pixels so that the samples on screen can be reused, the
+    // remainder is carried over to the next frame
+    f64 pan_x = 0.0;
+    f64 pan_y = 0.0;
+
+    // Zooms are snapped to factors of two along the pixel lattice for the same reason, the
+    // scroll steps are accumulated until they amount to one. The view stays on the global
+    // lattice of its zoom level, so revisited regions are found in the tile cache
+    f64 zoom = 0.0;
     while (display_running(&display)) {
+        // Drag to pan, scroll to zoom around the cursor
+        bool visible = display.width > 0 && display.height > 0;
+        if (visible && (display.width != view.width || display.height != view.height)) {
+            fractal_view_resize(&view, display.width, display.height);
+            fractal_view_snap(&view);
+        }
+        pan_x += display.input.drag_x;
+        pan_y += display.input.drag_y;
+        fractal_view_pan(&view, round(pan_x), round(pan_y));
+        pan_x -= round(pan_x);
+        pan_y -= round(pan_y);
+        zoom += display.input.scroll * log2(ZOOM_STEP);
+        if (fabs(zoom) >= 1.0) {
+            fractal_view_zoom_aligned(&view, display.input.cursor_x, display.input.cursor_y, zoom > 0.0);
+            view.max_iterations = (u32) s32_max((s32) view.max_iterations, (s32) fractal_view_depth_iterations(&view));
+            zoom -= zoom > 0.0 ? 1.0 : -1.0;
+        }
+
+        // Every frame presents the next refinement level of the view, a coarse image is on
+        // screen right after each change. The gpu renders every view in one go, its limit
+        // only follows the zoom depth
         glClear(GL_COLOR_BUFFER_BIT);
-        fractal_pipeline_submit(&pipeline, display.width, display.height);
+        if (gpu) {
+            fractal_pipeline_submit(&pipeline, &view);
+            display_update_frame(&display);
+            continue;
+        }
+        bool pending = fractal_pipeline_refine(&pipeline, &pool, &view);
+        if (refining && !pending) {
+            view.max_iterations = fractal_view_adapt_iterations(&pipeline.refine.view, pipeline.refine.iterations,
+                                                                FRACTAL_ITERATIONS_THRESHOLD);
+        }
+        refining = pending;
         display_update_frame(&display);
     }
 
     // Cleanup
+    thread_pool_destroy(&pool);
     fractal_pipeline_destroy(&pipeline);
     display_destroy(&display);
 